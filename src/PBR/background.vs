@@ -1,8 +1,15 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+// ÿ֡͹Դݣuniform_buffer.hеFrameUniformDataӦ
+layout (std140) uniform FrameUniforms
+{
+    mat4 projection;
+    mat4 view;
+    vec3 camPos;
+    vec3 lightPositions[4];
+    vec3 lightColors[4];
+};
 
 out vec3 WorldPos;
 
@@ -0,0 +1,630 @@
+#ifndef BC_ENCODER_H
+#define BC_ENCODER_H
+
+#include <cooked_texture.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BC_ENCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+// CPU˵BC1/BC4/BC5/BC7ѹߺ決
+// ÿ4x4鰴ֿͨţSoAͶӰһδ4أSSE2
+// ͼзָ̳߳زб롣BC7ֻʹģʽ6ӼRGBA4λٶȱȽϾ
+
+// һ4x4أֿͨԱSIMDһδ4
+struct BlockPixels {
+    alignas(16) float r[16];
+    alignas(16) float g[16];
+    alignas(16) float b[16];
+    alignas(16) float a[16];
+};
+
+// ͼȡһ4x4飬ͼ߽ĲظԵأȱٵͨΪ0ȱalphaʱΪ255
+inline void loadBlock(const unsigned char* pixels, int width, int height, int nrComponents, int blockX, int blockY, BlockPixels& block)
+{
+    for (int y = 0; y < 4; y++)
+    {
+        int sy = std::min(blockY * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++)
+        {
+            int sx = std::min(blockX * 4 + x, width - 1);
+            const unsigned char* p = pixels + ((size_t)sy * width + sx) * nrComponents;
+            int i = y * 4 + x;
+            block.r[i] = p[0];
+            block.g[i] = nrComponents > 1 ? p[1] : 0.0f;
+            block.b[i] = nrComponents > 2 ? p[2] : 0.0f;
+            block.a[i] = nrComponents > 3 ? p[3] : 255.0f;
+        }
+    }
+}
+
+// t[i] = dot(p[i] - origin, axis)
+inline void projectBlock(const BlockPixels& block, const float origin[4], const float axis[4], float t[16])
+{
+#ifdef BC_ENCODER_SSE2
+    __m128 or_ = _mm_set1_ps(origin[0]), og = _mm_set1_ps(origin[1]), ob = _mm_set1_ps(origin[2]), oa = _mm_set1_ps(origin[3]);
+    __m128 ar = _mm_set1_ps(axis[0]), ag = _mm_set1_ps(axis[1]), ab = _mm_set1_ps(axis[2]), aa = _mm_set1_ps(axis[3]);
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 d = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.r + i), or_), ar);
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.g + i), og), ag));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.b + i), ob), ab));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.a + i), oa), aa));
+        _mm_storeu_ps(t + i, d);
+    }
+#else
+    for (int i = 0; i < 16; i++)
+        t[i] = (block.r[i] - origin[0]) * axis[0] + (block.g[i] - origin[1]) * axis[1]
+             + (block.b[i] - origin[2]) * axis[2] + (block.a[i] - origin[3]) * axis[3];
+#endif
+}
+
+// ֮䰴ͨȨƽ֮
+inline float blockError(const BlockPixels& x, const BlockPixels& y, const float weights[4])
+{
+#ifdef BC_ENCODER_SSE2
+    __m128 wr = _mm_set1_ps(weights[0]), wg = _mm_set1_ps(weights[1]), wb = _mm_set1_ps(weights[2]), wa = _mm_set1_ps(weights[3]);
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 dr = _mm_sub_ps(_mm_load_ps(x.r + i), _mm_load_ps(y.r + i));
+        __m128 dg = _mm_sub_ps(_mm_load_ps(x.g + i), _mm_load_ps(y.g + i));
+        __m128 db = _mm_sub_ps(_mm_load_ps(x.b + i), _mm_load_ps(y.b + i));
+        __m128 da = _mm_sub_ps(_mm_load_ps(x.a + i), _mm_load_ps(y.a + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(dr, dr), wr));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(dg, dg), wg));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(db, db), wb));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(da, da), wa));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float dr = x.r[i] - y.r[i], dg = x.g[i] - y.g[i], db = x.b[i] - y.b[i], da = x.a[i] - y.a[i];
+        sum += dr * dr * weights[0] + dg * dg * weights[1] + db * db * weights[2] + da * da * weights[3];
+    }
+    return sum;
+#endif
+}
+
+// ɫľֵ᷽ЭݵweightsΪ0ͨ
+inline void principalAxis(const BlockPixels& block, const float weights[4], float mean[4], float axis[4])
+{
+    const float* channels[4] = { block.r, block.g, block.b, block.a };
+    for (int c = 0; c < 4; c++)
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < 16; i++)
+            sum += channels[c][i];
+        mean[c] = sum / 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float d[4];
+        for (int c = 0; c < 4; c++)
+            d[c] = (channels[c][i] - mean[c]) * weights[c];
+        for (int r = 0; r < 4; r++)
+            for (int c = r; c < 4; c++)
+                covariance[r][c] += d[r] * d[c];
+    }
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < r; c++)
+            covariance[r][c] = covariance[c][r];
+
+    // ԸͨΧΪʼܿ
+    float v[4];
+    for (int c = 0; c < 4; c++)
+    {
+        float lo = channels[c][0], hi = channels[c][0];
+        for (int i = 1; i < 16; i++)
+        {
+            lo = std::min(lo, channels[c][i]);
+            hi = std::max(hi, channels[c][i]);
+        }
+        v[c] = (hi - lo) * weights[c];
+    }
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4];
+        for (int r = 0; r < 4; r++)
+            next[r] = covariance[r][0] * v[0] + covariance[r][1] * v[1] + covariance[r][2] * v[2] + covariance[r][3] * v[3];
+        float length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::max(std::fabs(next[2]), std::fabs(next[3])));
+        if (length < 1e-8f)
+            break;
+        for (int c = 0; c < 4; c++)
+            v[c] = next[c] / length;
+    }
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+    for (int c = 0; c < 4; c++)
+        axis[c] = length > 1e-8f ? v[c] / length : 0.0f;
+}
+
+// ͶӰķΧõʼ˵
+inline void initialEndpoints(const BlockPixels& block, const float weights[4], float e0[4], float e1[4])
+{
+    float mean[4], axis[4], t[16];
+    principalAxis(block, weights, mean, axis);
+    projectBlock(block, mean, axis, t);
+    float tMin = t[0], tMax = t[0];
+    for (int i = 1; i < 16; i++)
+    {
+        tMin = std::min(tMin, t[i]);
+        tMax = std::max(tMax, t[i]);
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = std::min(std::max(mean[c] + axis[c] * tMin, 0.0f), 255.0f);
+        e1[c] = std::min(std::max(mean[c] + axis[c] * tMax, 0.0f), 255.0f);
+    }
+}
+
+// ÿصĲֵϵs0Ϊe01Ϊe1С˵㣬˻ʱfalse
+inline bool refitEndpoints(const BlockPixels& block, const float s[16], float e0[4], float e1[4])
+{
+    const float* channels[4] = { block.r, block.g, block.b, block.a };
+    float a11 = 0.0f, a12 = 0.0f, a22 = 0.0f;
+    float b1[4] = {}, b2[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float w0 = 1.0f - s[i], w1 = s[i];
+        a11 += w0 * w0;
+        a12 += w0 * w1;
+        a22 += w1 * w1;
+        for (int c = 0; c < 4; c++)
+        {
+            b1[c] += w0 * channels[c][i];
+            b2[c] += w1 * channels[c][i];
+        }
+    }
+    float det = a11 * a22 - a12 * a12;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = std::min(std::max((a22 * b1[c] - a12 * b2[c]) / det, 0.0f), 255.0f);
+        e1[c] = std::min(std::max((a11 * b2[c] - a12 * b1[c]) / det, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+// ######################################
+// # BC1
+// ######################################
+inline uint16_t packRGB565(const float color[4])
+{
+    int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t value, float color[4])
+{
+    int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+    color[0] = static_cast<float>((r << 3) | (r >> 2));
+    color[1] = static_cast<float>((g << 2) | (g >> 4));
+    color[2] = static_cast<float>((b << 3) | (b >> 2));
+    color[3] = 255.0f;
+}
+
+// ΪĶ˵ѡÿصĲֵ0..30Ϊc03Ϊc1RGB
+inline float selectBC1Steps(const BlockPixels& block, uint16_t c0, uint16_t c1, int steps[16], BlockPixels& decoded)
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    float p0[4], p1[4], axis[4], t[16];
+    unpackRGB565(c0, p0);
+    unpackRGB565(c1, p1);
+    float lengthSq = 0.0f;
+    for (int c = 0; c < 4; c++)
+    {
+        axis[c] = (p1[c] - p0[c]) * weights[c];
+        lengthSq += axis[c] * axis[c];
+    }
+    projectBlock(block, p0, axis, t);
+    float scale = lengthSq > 0.0f ? 3.0f / lengthSq : 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        steps[i] = std::min(std::max(static_cast<int>(t[i] * scale + 0.5f), 0), 3);
+        float s = steps[i] / 3.0f;
+        decoded.r[i] = p0[0] + (p1[0] - p0[0]) * s;
+        decoded.g[i] = p0[1] + (p1[1] - p0[1]) * s;
+        decoded.b[i] = p0[2] + (p1[2] - p0[2]) * s;
+        decoded.a[i] = block.a[i];
+    }
+    return blockError(block, decoded, weights);
+}
+
+// һBC1飨͸4ɫģʽ˵֮һСϣȡСĽ
+inline void encodeBC1Block(const BlockPixels& block, unsigned char* out)
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    float e0[4], e1[4];
+    initialEndpoints(block, weights, e0, e1);
+
+    uint16_t bestC0 = 0, bestC1 = 0;
+    int bestSteps[16] = {};
+    float bestError = 1e30f;
+    BlockPixels decoded;
+    for (int iteration = 0; iteration < 2; iteration++)
+    {
+        uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+        int steps[16];
+        float error = selectBC1Steps(block, c0, c1, steps, decoded);
+        if (error < bestError)
+        {
+            bestError = error;
+            bestC0 = c0;
+            bestC1 = c1;
+            memcpy(bestSteps, steps, sizeof(steps));
+        }
+        float s[16];
+        for (int i = 0; i < 16; i++)
+            s[i] = steps[i] / 3.0f;
+        if (bestError == 0.0f || !refitEndpoints(block, s, e0, e1))
+            break;
+    }
+
+    // 4ɫģʽҪc0 > c1򽻻˵㲢ת˵ͬʱֻ3ɫģʽȫȡc0
+    if (bestC0 < bestC1)
+    {
+        std::swap(bestC0, bestC1);
+        for (int i = 0; i < 16; i++)
+            bestSteps[i] = 3 - bestSteps[i];
+    }
+    static const unsigned int stepToIndex[4] = { 0, 2, 3, 1 };
+    uint32_t indices = 0;
+    if (bestC0 != bestC1)
+    {
+        for (int i = 0; i < 16; i++)
+            indices |= stepToIndex[bestSteps[i]] << (i * 2);
+    }
+    out[0] = static_cast<unsigned char>(bestC0 & 0xFF);
+    out[1] = static_cast<unsigned char>(bestC0 >> 8);
+    out[2] = static_cast<unsigned char>(bestC1 & 0xFF);
+    out[3] = static_cast<unsigned char>(bestC1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+// ######################################
+// # BC4 / BC5
+// ######################################
+// һͨBC4飨8ֵģʽr0 > r1
+inline void encodeBC4Block(const float values[16], unsigned char* out)
+{
+    float lo = values[0], hi = values[0];
+    for (int i = 1; i < 16; i++)
+    {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    int r0 = static_cast<int>(hi + 0.5f);
+    int r1 = static_cast<int>(lo + 0.5f);
+
+    uint64_t indices = 0;
+    if (r0 != r1)
+    {
+        // 0..7r0r1ӦΪ0, 2, 3, 4, 5, 6, 7, 1
+        float scale = 7.0f / (r0 - r1);
+        for (int i = 0; i < 16; i++)
+        {
+            int step = std::min(std::max(static_cast<int>((r0 - values[i]) * scale + 0.5f), 0), 7);
+            uint64_t index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+            indices |= index << (i * 3);
+        }
+    }
+    out[0] = static_cast<unsigned char>(r0);
+    out[1] = static_cast<unsigned char>(r1);
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+// ######################################
+// # BC7ģʽ6
+// ######################################
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 0..64ͶӰλӳ䵽4λȨ
+struct BC7NearestWeight {
+    int index[65];
+
+    BC7NearestWeight()
+    {
+        for (int t = 0; t <= 64; t++)
+        {
+            int best = 0;
+            for (int i = 1; i < 16; i++)
+                if (std::abs(BC7_WEIGHTS4[i] - t) < std::abs(BC7_WEIGHTS4[best] - t))
+                    best = i;
+            index[t] = best;
+        }
+    }
+};
+
+// Ѷ˵Ϊ7λ+PλֱP=0/1ȡСһ
+inline void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pbit)
+{
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; p++)
+    {
+        int q[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            q[c] = std::min(std::max(static_cast<int>((endpoint[c] - p) * 0.5f + 0.5f), 0), 127);
+            float d = static_cast<float>((q[c] << 1) | p) - endpoint[c];
+            error += d * d;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            pbit = p;
+            memcpy(quantized, q, sizeof(q));
+        }
+    }
+}
+
+// ΪĶ˵ѡÿص4λRGBA
+inline float selectBC7Indices(const BlockPixels& block, const int q0[4], int p0, const int q1[4], int p1, int indices[16], BlockPixels& decoded)
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    static const BC7NearestWeight nearestWeight;
+
+    int e0[4], e1[4];
+    float origin[4], axis[4];
+    float lengthSq = 0.0f;
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = (q0[c] << 1) | p0;
+        e1[c] = (q1[c] << 1) | p1;
+        origin[c] = static_cast<float>(e0[c]);
+        axis[c] = static_cast<float>(e1[c] - e0[c]);
+        lengthSq += axis[c] * axis[c];
+    }
+    float t[16];
+    projectBlock(block, origin, axis, t);
+    float scale = lengthSq > 0.0f ? 64.0f / lengthSq : 0.0f;
+    float* channels[4] = { decoded.r, decoded.g, decoded.b, decoded.a };
+    for (int i = 0; i < 16; i++)
+    {
+        int position = std::min(std::max(static_cast<int>(t[i] * scale + 0.5f), 0), 64);
+        indices[i] = nearestWeight.index[position];
+        int w = BC7_WEIGHTS4[indices[i]];
+        for (int c = 0; c < 4; c++)
+            channels[c][i] = static_cast<float>(((64 - w) * e0[c] + w * e1[c] + 32) >> 6);
+    }
+    return blockError(block, decoded, weights);
+}
+
+// λӵ͵д128λĿ
+class BlockBitWriter
+{
+public:
+    explicit BlockBitWriter(unsigned char* out) : out(out), position(0)
+    {
+        memset(out, 0, 16);
+    }
+
+    void write(unsigned int value, int bits)
+    {
+        for (int i = 0; i < bits; i++, position++)
+            out[position >> 3] |= static_cast<unsigned char>(((value >> i) & 1) << (position & 7));
+    }
+
+private:
+    unsigned char* out;
+    int position;
+};
+
+// һBC7飨ģʽ6˵֮СϣȡСĽ
+inline void encodeBC7Block(const BlockPixels& block, unsigned char* out)
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float e0[4], e1[4];
+    initialEndpoints(block, weights, e0, e1);
+
+    int bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+    int bestIndices[16] = {};
+    float bestError = 1e30f;
+    BlockPixels decoded;
+    for (int iteration = 0; iteration < 3; iteration++)
+    {
+        int q0[4], q1[4], p0, p1, indices[16];
+        quantizeBC7Endpoint(e0, q0, p0);
+        quantizeBC7Endpoint(e1, q1, p1);
+        float error = selectBC7Indices(block, q0, p0, q1, p1, indices, decoded);
+        if (error < bestError)
+        {
+            bestError = error;
+            memcpy(bestQ0, q0, sizeof(q0));
+            memcpy(bestQ1, q1, sizeof(q1));
+            bestP0 = p0;
+            bestP1 = p1;
+            memcpy(bestIndices, indices, sizeof(indices));
+        }
+        float s[16];
+        for (int i = 0; i < 16; i++)
+            s[i] = BC7_WEIGHTS4[indices[i]] / 64.0f;
+        if (bestError == 0.0f || !refitEndpoints(block, s, e0, e1))
+            break;
+    }
+
+    // 0صλΪ0ʱ˵㲢ת
+    if (bestIndices[0] >= 8)
+    {
+        for (int c = 0; c < 4; c++)
+            std::swap(bestQ0[c], bestQ1[c]);
+        std::swap(bestP0, bestP1);
+        for (int i = 0; i < 16; i++)
+            bestIndices[i] = 15 - bestIndices[i];
+    }
+
+    BlockBitWriter writer(out);
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        writer.write(bestQ0[c], 7);
+        writer.write(bestQ1[c], 7);
+    }
+    writer.write(bestP0, 1);
+    writer.write(bestP1, 1);
+    writer.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; i++)
+        writer.write(bestIndices[i], 4);
+}
+
+// ######################################
+// # ͼ
+// ######################################
+inline void compressBlock(const unsigned char* pixels, int width, int height, int nrComponents, uint32_t format, int blockX, int blockY, unsigned char* out)
+{
+    BlockPixels block;
+    loadBlock(pixels, width, height, nrComponents, blockX, blockY, block);
+    if (format == COOKED_FORMAT_BC1)
+        encodeBC1Block(block, out);
+    else if (format == COOKED_FORMAT_BC4)
+        encodeBC4Block(block.r, out);
+    else if (format == COOKED_FORMAT_BC5)
+    {
+        encodeBC4Block(block.r, out);
+        encodeBC4Block(block.g, out + 8);
+    }
+    else if (format == COOKED_FORMAT_BC7)
+        encodeBC7Block(block, out);
+}
+
+// ͼѹΪBCʽзֳɶν̳߳زб룻poolΪʱڵ̴߳б롣
+// ͬһ̳߳صĹ߳д̳߳أụȴ
+inline void compressImage(const unsigned char* pixels, int width, int height, int nrComponents, uint32_t format, std::vector<unsigned char>& out, ThreadPool* pool = nullptr)
+{
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    size_t blockBytes = cookedBlockBytes(format);
+    out.resize((size_t)blocksX * blocksY * blockBytes);
+    unsigned char* dst = out.data();
+
+    auto encodeRows = [=](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; y++)
+            for (int x = 0; x < blocksX; x++)
+                compressBlock(pixels, width, height, nrComponents, format, x, y, dst + ((size_t)y * blocksX + x) * blockBytes);
+    };
+
+    if (!pool || pool->size() <= 1 || blocksY < 2)
+    {
+        encodeRows(0, blocksY);
+        return;
+    }
+    // ÿ̷ֵ߳ɶΣαʱ߳̿յ
+    int rowsPerTask = std::max(1, blocksY / static_cast<int>(pool->size() * 4));
+    std::vector<std::future<void>> tasks;
+    for (int y = 0; y < blocksY; y += rowsPerTask)
+    {
+        int lastRow = std::min(y + rowsPerTask, blocksY);
+        tasks.push_back(pool->enqueue([=] { encodeRows(y, lastRow); }));
+    }
+    for (unsigned int i = 0; i < tasks.size(); i++)
+        tasks[i].get();
+}
+
+// ######################################
+// # 루
+// ######################################
+// һBC1Ϊ16RGBA
+inline void decodeBC1Block(const unsigned char* in, unsigned char out[16][4])
+{
+    uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    float p[4][4];
+    unpackRGB565(c0, p[0]);
+    unpackRGB565(c1, p[1]);
+    for (int c = 0; c < 4; c++)
+    {
+        if (c0 > c1)
+        {
+            p[2][c] = (2.0f * p[0][c] + p[1][c]) / 3.0f;
+            p[3][c] = (p[0][c] + 2.0f * p[1][c]) / 3.0f;
+        }
+        else
+        {
+            p[2][c] = (p[0][c] + p[1][c]) / 2.0f;
+            p[3][c] = 0.0f;
+        }
+    }
+    uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+    for (int i = 0; i < 16; i++)
+    {
+        int index = (indices >> (i * 2)) & 3;
+        for (int c = 0; c < 4; c++)
+            out[i][c] = static_cast<unsigned char>(p[index][c] + 0.5f);
+    }
+}
+
+// һBC4Ϊ16ֵͨ
+inline void decodeBC4Block(const unsigned char* in, unsigned char out[16])
+{
+    int r0 = in[0], r1 = in[1];
+    int palette[8] = { r0, r1 };
+    for (int i = 2; i < 8; i++)
+    {
+        if (r0 > r1)
+            palette[i] = ((8 - i) * r0 + (i - 1) * r1 + 3) / 7;
+        else if (i < 6)
+            palette[i] = ((6 - i) * r0 + (i - 1) * r1 + 2) / 5;
+        else
+            palette[i] = i == 6 ? 0 : 255;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= (uint64_t)in[2 + i] << (i * 8);
+    for (int i = 0; i < 16; i++)
+        out[i] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+}
+
+// һBC7Ϊ16RGBAأֱֻ֧ģʽ6ģʽfalse
+inline bool decodeBC7Block(const unsigned char* in, unsigned char out[16][4])
+{
+    int position = 0;
+    auto read = [&](int bits) {
+        unsigned int value = 0;
+        for (int i = 0; i < bits; i++, position++)
+            value |= ((in[position >> 3] >> (position & 7)) & 1u) << i;
+        return value;
+    };
+    if (read(7) != (1u << 6))
+        return false;
+    int e[2][4];
+    for (int c = 0; c < 4; c++)
+    {
+        e[0][c] = read(7) << 1;
+        e[1][c] = read(7) << 1;
+    }
+    unsigned int p0 = read(1), p1 = read(1);
+    for (int c = 0; c < 4; c++)
+    {
+        e[0][c] |= p0;
+        e[1][c] |= p1;
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        int w = BC7_WEIGHTS4[read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; c++)
+            out[i][c] = static_cast<unsigned char>(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,28 @@
+#ifndef BRDF_LUT_H
+#define BRDF_LUT_H
+
+#include <glad/glad.h>
+
+// BRDFֲұκ룬ÿʱȾڹʱIblBaker --brdf-lut
+// brdf_lut_data.hPBRĿԤ¼ߴ//ȼPBR.vcxprojеBrdfLut*꣩Ծ̬Ƕ
+// ɵͷļBRDF_LUT_SIZEBRDF_LUT_SAMPLE_COUNTBRDF_LUT_HALF_FLOATbrdfLutDataRGȣ
+#include <brdf_lut_data.h>
+
+// ǶBRDF LUTϴΪ뾫ΪGL_RG16FΪGL_RG32F
+inline unsigned int uploadBrdfLut()
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+#if BRDF_LUT_HALF_FLOAT
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, BRDF_LUT_SIZE, BRDF_LUT_SIZE, 0, GL_RG, GL_HALF_FLOAT, brdfLutData);
+#else
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, BRDF_LUT_SIZE, BRDF_LUT_SIZE, 0, GL_RG, GL_FLOAT, brdfLutData);
+#endif
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return textureID;
+}
+#endif
@@ -0,0 +1,161 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <glad/glad.h>
+
+#include <gl_state_cache.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// GL 4.3ɫصö١gladֻ3.3ĵļЩöٺĺҪԼͼ
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_UPDATE_BARRIER_BIT
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+
+// ɫõGL 4.2/4.3ԱMemoryBarrierWindowsͷļеĺͻ
+struct GLComputeFunctions {
+    void (APIENTRYP dispatchCompute)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ) = nullptr;
+    void (APIENTRYP bindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) = nullptr;
+    void (APIENTRYP memoryBarrier)(GLbitfield barriers) = nullptr;
+};
+
+inline GLComputeFunctions& glCompute()
+{
+    static GLComputeFunctions functions;
+    return functions;
+}
+
+// ôϵͳĺglfwGetProcAddressؼɫǰĲ֧ʱfalse
+inline bool loadGLCompute(GLADloadproc load)
+{
+    GLComputeFunctions& functions = glCompute();
+    functions.dispatchCompute = reinterpret_cast<void (APIENTRYP)(GLuint, GLuint, GLuint)>(load("glDispatchCompute"));
+    functions.bindImageTexture = reinterpret_cast<void (APIENTRYP)(GLuint, GLuint, GLint, GLboolean, GLint, GLenum, GLenum)>(load("glBindImageTexture"));
+    functions.memoryBarrier = reinterpret_cast<void (APIENTRYP)(GLbitfield)>(load("glMemoryBarrier"));
+    return functions.dispatchCompute && functions.bindImageTexture && functions.memoryBarrier;
+}
+
+// ######################################
+// # Class ComputeShader
+// ######################################
+class ComputeShader
+{
+public:
+    unsigned int ID;
+    // 캯ļɫdefines뵽#version֮Shaderͬ
+    ComputeShader(const char* computePath, const std::string& defines = std::string())
+    {
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = addDefines(cShaderStream.str(), defines);
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        }
+        const char* cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+    }
+    ~ComputeShader()
+    {
+        glDeleteProgram(ID);
+    }
+    ComputeShader(const ComputeShader&) = delete;
+    ComputeShader& operator=(const ComputeShader&) = delete;
+
+    // ɫ
+    void use()
+    {
+        GLStateCache::instance().useProgram(ID);
+    }
+    // x * y * zִ
+    void dispatch(unsigned int x, unsigned int y = 1, unsigned int z = 1)
+    {
+        glCompute().dispatchCompute(x, y, z);
+    }
+    // ߺuniform
+    void setInt(const std::string &name, int value) const
+    {
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string &name, float value) const
+    {
+        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    }
+
+private:
+    // #version֮궨
+    static std::string addDefines(const std::string& code, const std::string& defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t insertAt = 0;
+        size_t version = code.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = code.find('\n', version);
+            insertAt = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        }
+        return code.substr(0, insertAt) + defines + code.substr(insertAt);
+    }
+
+    // ɫ/Ӵ
+    void checkCompileErrors(GLuint shader, std::string type)
+    {
+        GLint success;
+        GLchar infoLog[1024];
+        if(type != "PROGRAM")
+        {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if(!success)
+            {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else
+        {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if(!success)
+            {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+    }
+};
+#endif
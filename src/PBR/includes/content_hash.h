@@ -0,0 +1,46 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <mapped_file.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 64λݹϣ8ִֽFNV-1aջϣжϻǷԴļӦǼ;
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+{
+    const uint64_t prime = 0x100000001b3ull;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed ^ (size * prime);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * prime;
+    // ջϣsplitmix64
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+// ӳ䲢ϣļļڻΪʱfalse
+inline bool hashFileContents(const std::string& path, uint64_t& hash, uint64_t* fileSize = nullptr)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    hash = hashBytes(file.data(), file.size());
+    if (fileSize)
+        *fileSize = file.size();
+    return true;
+}
+#endif
@@ -0,0 +1,253 @@
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include <file_system.h>
+#include <mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ߺ決.ctexKTX2ļͷ + mip + 16ֽڶĸݡ
+// ʱֱӳļϴҪ룬ҲҪglGenerateMipmap
+const uint32_t COOKED_TEXTURE_VERSION = 1;
+const uint32_t COOKED_TEXTURE_ALIGNMENT = 16;
+
+// ظʽBCʽ4x4ؿ洢
+enum CookedTextureFormat : uint32_t {
+    COOKED_FORMAT_UNCOMPRESSED = 0,     // ÿnrComponentsֽ
+    COOKED_FORMAT_BC1 = 1,              // RGBÿ8ֽ
+    COOKED_FORMAT_BC4 = 2,              // ͨRÿ8ֽ
+    COOKED_FORMAT_BC5 = 3,              // ˫ͨRGÿ16ֽ
+    COOKED_FORMAT_BC7 = 4               // RGBAÿ16ֽ
+};
+
+// ־λ
+enum CookedTextureFlags : uint32_t {
+    COOKED_FLAG_FLIPPED_VERTICALLY = 1  // 決ʱѴֱת
+};
+
+struct CookedTextureHeader {
+    char magic[4];          // "PBRT"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t nrComponents;
+    uint32_t format;        // CookedTextureFormat
+    uint32_t levelCount;
+    uint32_t flags;         // CookedTextureFlags
+};
+
+struct CookedTextureLevel {
+    uint64_t offset;        // ļͷƫ
+    uint64_t size;          // ֽ
+    uint32_t width;
+    uint32_t height;
+};
+
+// дʱĳһ
+struct CookedLevelData {
+    int width;
+    int height;
+    const unsigned char* data;
+    size_t size;
+};
+
+// BCʽÿ4x4ֽѹʽ0
+inline size_t cookedBlockBytes(uint32_t format)
+{
+    if (format == COOKED_FORMAT_BC1 || format == COOKED_FORMAT_BC4)
+        return 8;
+    if (format == COOKED_FORMAT_BC5 || format == COOKED_FORMAT_BC7)
+        return 16;
+    return 0;
+}
+
+// ĳһݴС
+inline size_t cookedLevelSize(uint32_t format, int width, int height, int nrComponents)
+{
+    size_t blockBytes = cookedBlockBytes(format);
+    if (blockBytes == 0)
+        return (size_t)width * height * nrComponents;
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+// ԴͼӦĺ決ļ·
+inline std::string cookedTexturePath(const std::string& sourcePath)
+{
+    return sourcePath + ".ctex";
+}
+
+// 2x2ʽ˲һmipߴʱԵظʹã
+inline void downsampleImage(const unsigned char* src, int width, int height, int nrComponents, std::vector<unsigned char>& dst, int& dstWidth, int& dstHeight)
+{
+    dstWidth = std::max(1, width / 2);
+    dstHeight = std::max(1, height / 2);
+    dst.resize((size_t)dstWidth * dstHeight * nrComponents);
+    for (int y = 0; y < dstHeight; y++)
+    {
+        int y0 = std::min(y * 2, height - 1);
+        int y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < dstWidth; x++)
+        {
+            int x0 = std::min(x * 2, width - 1);
+            int x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < nrComponents; c++)
+            {
+                unsigned int sum = src[((size_t)y0 * width + x0) * nrComponents + c] + src[((size_t)y0 * width + x1) * nrComponents + c]
+                                 + src[((size_t)y1 * width + x0) * nrComponents + c] + src[((size_t)y1 * width + x1) * nrComponents + c];
+                dst[((size_t)y * dstWidth + x) * nrComponents + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+// ɵ11x1mip0
+inline std::vector<std::vector<unsigned char>> generateMipChain(const unsigned char* data, int width, int height, int nrComponents, std::vector<int>& widths, std::vector<int>& heights)
+{
+    std::vector<std::vector<unsigned char>> levels;
+    const unsigned char* src = data;
+    while (width > 1 || height > 1)
+    {
+        levels.push_back(std::vector<unsigned char>());
+        int nextWidth, nextHeight;
+        downsampleImage(src, width, height, nrComponents, levels.back(), nextWidth, nextHeight);
+        width = nextWidth;
+        height = nextHeight;
+        widths.push_back(width);
+        heights.push_back(height);
+        src = levels.back().data();
+    }
+    return levels;
+}
+
+// д決ļheaderеlevelCountlevels
+inline bool writeCookedTexture(const std::string& path, CookedTextureHeader header, const std::vector<CookedLevelData>& levels)
+{
+    memcpy(header.magic, "PBRT", 4);
+    header.version = COOKED_TEXTURE_VERSION;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    std::vector<CookedTextureLevel> table(levels.size());
+    uint64_t offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureLevel) * levels.size();
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        offset = (offset + COOKED_TEXTURE_ALIGNMENT - 1) / COOKED_TEXTURE_ALIGNMENT * COOKED_TEXTURE_ALIGNMENT;
+        table[i].offset = offset;
+        table[i].size = levels[i].size;
+        table[i].width = levels[i].width;
+        table[i].height = levels[i].height;
+        offset += levels[i].size;
+    }
+
+    // дʱļ滻жʱ²ĺ決ļԴͼ£ᱻЧļӳ䣩
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), sizeof(CookedTextureLevel) * table.size());
+        const char padding[COOKED_TEXTURE_ALIGNMENT] = { 0 };
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(table[i].offset - position));
+            file.write(reinterpret_cast<const char*>(levels[i].data), static_cast<std::streamsize>(levels[i].size));
+        }
+        if (!file.good())
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+// ######################################
+// # Class CookedTextureView
+// ######################################
+// ӳڴеĺ決ֻͼֻУ鲻
+class CookedTextureView
+{
+public:
+    const CookedTextureHeader* header;
+    const CookedTextureLevel* levels;
+
+    CookedTextureView() : header(nullptr), levels(nullptr), base(nullptr)
+    {
+    }
+
+    // Уļͷ͸ķΧԼĳߴǷΪӵ0ļͷߴͬʼ𼶼mip
+    // СǷߴ͸ʽһ¡ɹɷheader/levels/levelData()
+    bool parse(const unsigned char* data, size_t size)
+    {
+        header = nullptr;
+        levels = nullptr;
+        base = data;
+        if (!data || size < sizeof(CookedTextureHeader))
+            return false;
+        const CookedTextureHeader* candidate = reinterpret_cast<const CookedTextureHeader*>(data);
+        if (memcmp(candidate->magic, "PBRT", 4) != 0 || candidate->version != COOKED_TEXTURE_VERSION || candidate->levelCount == 0
+            || candidate->format > COOKED_FORMAT_BC7 || candidate->width == 0 || candidate->height == 0)
+            return false;
+        if (candidate->format == COOKED_FORMAT_UNCOMPRESSED && (candidate->nrComponents == 0 || candidate->nrComponents > 4))
+            return false;
+        if (sizeof(CookedTextureHeader) + sizeof(CookedTextureLevel) * (size_t)candidate->levelCount > size)
+            return false;
+        const CookedTextureLevel* table = reinterpret_cast<const CookedTextureLevel*>(data + sizeof(CookedTextureHeader));
+        uint32_t width = candidate->width, height = candidate->height;
+        for (uint32_t i = 0; i < candidate->levelCount; i++)
+        {
+            // 1x1֮м
+            if (i > 0 && width == 1 && height == 1)
+                return false;
+            if (i > 0)
+            {
+                width = std::max(1u, width / 2);
+                height = std::max(1u, height / 2);
+            }
+            if (table[i].width != width || table[i].height != height)
+                return false;
+            if (table[i].offset > size || table[i].size > size - table[i].offset)
+                return false;
+            if (table[i].size != cookedLevelSize(candidate->format, table[i].width, table[i].height, candidate->nrComponents))
+                return false;
+        }
+        header = candidate;
+        levels = table;
+        return true;
+    }
+
+    const unsigned char* levelData(uint32_t level) const
+    {
+        return base + levels[level].offset;
+    }
+
+private:
+    const unsigned char* base;
+};
+
+// ӳԴͼӦĺ決ļ決ļڡԴͼɡʽЧתһʱfalse
+// Ӧ˻صԴͼԴͼ񲻴ʱֻҪк決ļʹ
+inline bool openCookedTexture(const std::string& sourcePath, bool flipVertically, MappedFile& file, CookedTextureView& view)
+{
+    std::string cookedPath = cookedTexturePath(sourcePath);
+    uint64_t cookedTime = fileModifiedTime(cookedPath);
+    if (cookedTime == 0 || cookedTime < fileModifiedTime(sourcePath))
+        return false;
+    if (!file.open(cookedPath))
+        return false;
+    bool flipped = false;
+    if (view.parse(file.data(), file.size()))
+        flipped = (view.header->flags & COOKED_FLAG_FLIPPED_VERTICALLY) != 0;
+    if (!view.header || flipped != flipVertically)
+    {
+        file.close();
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,322 @@
+#ifndef ENVIRONMENT_LIBRARY_H
+#define ENVIRONMENT_LIBRARY_H
+
+#include <glad/glad.h>
+
+#include <file_system.h>
+#include <ibl_baker.h>
+#include <ibl_cache.h>
+#include <ibl_upload.h>
+#include <mapped_file.h>
+#include <thread_pool.h>
+#include <work_stealing_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ######################################
+// # Class EnvironmentLibrary
+// ######################################
+// ʱлHDR⣺select()֮ں̨߳вIBL棬δʱHDRCPU決ibl_baker.h決д뻺棬
+// Ⱦ̲߳ȴÿ֡update()аʱԤϴ·ͼȫλ֡ʼʱһ滻
+// ͼԤͼͷնгϵɾȾʼʹcurrent()ῴϴһ
+class EnvironmentLibrary
+{
+public:
+    // uploadBudgetMsÿ֡ϴʱԤ㣨룩decodePoolнHDRɨߵ̳߳أΪnullptr
+    // bakeThreadsCPU決߳Ϊ0ʱһӲ̸߳Ⱦ߳
+    EnvironmentLibrary(const IblBakeParams& params, double uploadBudgetMs = 2.0, ThreadPool* decodePool = nullptr, unsigned int bakeThreads = 0)
+        : params(params), uploadBudgetMs(uploadBudgetMs), decodePool(decodePool), worker(1), activeIndex(-1), pendingIndex(-1), requestedIndex(-1),
+          uploadImage(0), uploadRow(0)
+    {
+        this->bakeThreads = bakeThreads != 0 ? bakeThreads : std::max(1u, ThreadPool::defaultThreadCount() - 1);
+        bakeKey = iblBakeKey(params, iblBakeShaderPaths());
+        active.environment = 0;
+        active.prefilter = 0;
+        pending.environment = 0;
+        pending.prefilter = 0;
+        memset(&activeSH, 0, sizeof(activeSH));
+    }
+
+    // ȴڽеĺ決GLһ٣
+    ~EnvironmentLibrary()
+    {
+        if (job.valid())
+            job.wait();
+    }
+
+    EnvironmentLibrary(const EnvironmentLibrary&) = delete;
+    EnvironmentLibrary& operator=(const EnvironmentLibrary&) = delete;
+
+    // Ŀ¼£ݹ飩.hdrļУ·
+    void scan(const std::string& directory)
+    {
+        std::vector<std::string> files;
+        listFilesRecursive(directory, files);
+        std::sort(files.begin(), files.end());
+        for (const std::string& file : files)
+            if (fileExtension(file) == "hdr")
+                add(file);
+    }
+
+    // һHDRļѴʱԭ
+    int add(const std::string& path)
+    {
+        std::string key = canonicalPath(path);
+        for (size_t i = 0; i < paths.size(); i++)
+            if (canonicalPath(paths[i]) == key)
+                return static_cast<int>(i);
+        paths.push_back(path);
+        return static_cast<int>(paths.size()) - 1;
+    }
+
+    // ӹʱѾ決ӻϴõIBLΪǰ
+    void adopt(const std::string& path, const IblTextures& textures, const IrradianceSH& irradianceSH)
+    {
+        activeIndex = add(path);
+        requestedIndex = activeIndex;
+        active = textures;
+        activeSH = irradianceSH;
+    }
+
+    // лindexء決ٴʱǰĺ決ɣд뻺棩ֻһ
+    void select(int index)
+    {
+        if (index >= 0 && index < static_cast<int>(paths.size()))
+            requestedIndex = index;
+    }
+
+    // ÿ֡ʼʱGL̵߳һΣ̨決Ԥϴɺ滻ǰ
+    // trueʾ֡л˻Ҫɫеķնгϵ
+    bool update()
+    {
+        if (job.valid() && job.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            bake = job.get();
+            if (!bake->valid)
+            {
+                // ʧʱֵǰ
+                std::cout << "EnvironmentLibrary: failed to load " << paths[bake->index] << std::endl;
+                if (requestedIndex == bake->index)
+                    requestedIndex = activeIndex;
+                bake.reset();
+            }
+            else if (bake->index != requestedIndex)
+                bake.reset();
+            else
+            {
+                // 洢ռһ֡ϴһ֡ʼ
+                beginUpload();
+                return false;
+            }
+        }
+        if (!job.valid() && !bake && requestedIndex != activeIndex && requestedIndex != pendingIndex)
+            startBake(requestedIndex);
+        if (!bake)
+            return false;
+
+        if (!uploadRows())
+            return false;
+        finishUpload();
+        return true;
+    }
+
+    // ǰʹõIBLͷնгϵֻupdate()иı
+    const IblTextures& current() const
+    {
+        return active;
+    }
+
+    const IrradianceSH& currentIrradianceSH() const
+    {
+        return activeSH;
+    }
+
+    int currentIndex() const
+    {
+        return activeIndex;
+    }
+
+    int requested() const
+    {
+        return requestedIndex;
+    }
+
+    // Ƿں決ϴ
+    bool busy() const
+    {
+        return job.valid() || bake != nullptr || requestedIndex != activeIndex;
+    }
+
+    int size() const
+    {
+        return static_cast<int>(paths.size());
+    }
+
+    const std::string& path(int index) const
+    {
+        return paths[index];
+    }
+
+private:
+    // ̨Ľлʱͼָӳڴ棬ָ決תİ뾫
+    struct BakedEnvironment {
+        int index = -1;
+        bool valid = false;
+        bool cached = false;
+        double bakeMs = 0.0;
+        IrradianceSH irradianceSH;
+        MappedFile file;
+        std::vector<std::vector<uint16_t>> storage;
+        std::vector<IblCacheImageData> images;
+    };
+
+    IblBakeParams params;
+    double uploadBudgetMs;
+    ThreadPool* decodePool;
+    unsigned int bakeThreads;
+    uint64_t bakeKey;
+    // ̨決ֻռһ̣߳決ڲWorkStealingPool
+    ThreadPool worker;
+    std::vector<std::string> paths;
+    std::future<std::shared_ptr<BakedEnvironment>> job;
+    std::shared_ptr<BakedEnvironment> bake;
+
+    IblTextures active;
+    IrradianceSH activeSH;
+    int activeIndex;
+    // ϴĻ
+    IblTextures pending;
+    int pendingIndex;
+    int requestedIndex;
+    size_t uploadImage;
+    uint32_t uploadRow;
+    std::chrono::high_resolution_clock::time_point selectTime;
+
+    void startBake(int index)
+    {
+        std::string path = paths[index];
+        IblBakeParams bakeParams = params;
+        uint64_t key = bakeKey;
+        ThreadPool* pool = decodePool;
+        unsigned int threads = bakeThreads;
+        selectTime = std::chrono::high_resolution_clock::now();
+        job = worker.enqueue([index, path, bakeParams, key, pool, threads] {
+            std::shared_ptr<BakedEnvironment> result = std::make_shared<BakedEnvironment>();
+            result->index = index;
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            IblCacheView view;
+            uint64_t sourceHash, sourceSize;
+            if (openIblCache(path, key, result->file, view, sourceHash, sourceSize))
+            {
+                result->cached = true;
+                result->irradianceSH = view.header->irradianceSH;
+                for (uint32_t i = 0; i < view.header->imageCount; i++)
+                {
+                    const IblCacheImage& image = view.images[i];
+                    result->images.push_back(IblCacheImageData{ image.texture, image.face, image.level, image.width, image.height, image.channels, view.imageData(i) });
+                }
+            }
+            else
+            {
+                IblImage source;
+                if (sourceSize == 0 || !loadIblSource(path, source, pool))
+                    return result;
+                WorkStealingPool bakePool(threads);
+                IblBakeResult baked;
+                bakeEnvironmentCube(source, static_cast<int>(bakeParams.environmentSize), bakePool, baked.environment);
+                baked.irradianceSH = projectEnvironmentSH(baked.environment, bakeParams, true);
+                bakePrefilter(baked.environment, bakeParams, bakePool, true, baked.prefilter);
+                result->irradianceSH = baked.irradianceSH;
+                collectIblCacheImages(baked, bakeParams, result->storage, result->images);
+                writeIblCache(path, sourceHash, sourceSize, key, result->irradianceSH, result->images);
+            }
+            result->valid = true;
+            result->bakeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            return result;
+        });
+    }
+
+    // Ϊ»洢ȫmip𣩣ʱͼͬ𼶷glGenerateMipmapʱGPU
+    static unsigned int allocateCubemap(uint32_t size)
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        for (uint32_t level = 0, levelSize = size; levelSize > 0; level++, levelSize >>= 1)
+            for (unsigned int i = 0; i < 6; ++i)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB16F, levelSize, levelSize, 0, GL_RGB, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+
+    void beginUpload()
+    {
+        pendingIndex = bake->index;
+        pending.environment = allocateCubemap(params.environmentSize);
+        pending.prefilter = allocateCubemap(params.prefilterSize);
+        uploadImage = 0;
+        uploadRow = 0;
+    }
+
+    // ʱԤϴȫʱtrueÿ֡ϴһ飬ԤСʱԶ޷
+    bool uploadRows()
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        const unsigned int ids[2] = { pending.environment, pending.prefilter };
+        bool uploaded = false;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (uploadImage < bake->images.size())
+        {
+            if (uploaded && std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= uploadBudgetMs)
+                break;
+            const IblCacheImageData& image = bake->images[uploadImage];
+            size_t rowSize = (size_t)image.width * image.channels * sizeof(uint16_t);
+            // ÿԼ64KB֮һʱ
+            uint32_t rows = std::min(image.height - uploadRow, std::max(1u, static_cast<uint32_t>(64 * 1024 / rowSize)));
+            glBindTexture(GL_TEXTURE_CUBE_MAP, ids[image.texture]);
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + image.face, image.level, 0, uploadRow, image.width, rows, GL_RGB, GL_HALF_FLOAT,
+                            static_cast<const unsigned char*>(image.data) + uploadRow * rowSize);
+            uploaded = true;
+            uploadRow += rows;
+            if (uploadRow == image.height)
+            {
+                uploadImage++;
+                uploadRow = 0;
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return uploadImage == bake->images.size();
+    }
+
+    // ͼֻϴ˵0mipmap滻ǰɾ
+    void finishUpload()
+    {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, pending.environment);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        glDeleteTextures(1, &active.environment);
+        glDeleteTextures(1, &active.prefilter);
+        active = pending;
+        activeSH = bake->irradianceSH;
+        activeIndex = pendingIndex;
+        pending.environment = 0;
+        pending.prefilter = 0;
+        pendingIndex = -1;
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - selectTime).count();
+        std::cout << "EnvironmentLibrary: " << paths[activeIndex] << (bake->cached ? " loaded from cache" : " baked on CPU") << " in " << bake->bakeMs
+                  << " ms, swapped after " << ms << " ms" << std::endl;
+        bake.reset();
+    }
+};
+#endif
@@ -0,0 +1,143 @@
+#ifndef FILE_SYSTEM_H
+#define FILE_SYSTEM_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ļǷڣҲĿ¼
+inline bool fileExists(const std::string& path)
+{
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+// ļ޸ʱ䣬ڱȽȺļʱ0
+inline uint64_t fileModifiedTime(const std::string& path)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data))
+        return 0;
+    return ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return 0;
+    return (uint64_t)st.st_mtime;
+#endif
+}
+
+// ļСֽڣֻȡļԣļļʱ0
+inline uint64_t fileSize(const std::string& path)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data))
+        return 0;
+    return ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return 0;
+    return (uint64_t)st.st_size;
+#endif
+}
+
+// Сдչ'.'ûչʱؿַ
+inline std::string fileExtension(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return std::string();
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return extension;
+}
+
+// 淶ľ·ָͳһΪ'/'WindowsתΪСдļʱֻ淶ָ
+inline std::string canonicalPath(const std::string& path)
+{
+    std::string result = path;
+#ifdef _WIN32
+    char buffer[MAX_PATH];
+    DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, buffer, NULL);
+    if (length > 0 && length < MAX_PATH)
+        result.assign(buffer, length);
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#else
+    if (char* resolved = realpath(path.c_str(), nullptr))
+    {
+        result = resolved;
+        free(resolved);
+    }
+#endif
+    std::replace(result.begin(), result.end(), '\\', '/');
+    return result;
+}
+
+// ݹгĿ¼µļ·ͳһʹ'/'ָ
+inline void listFilesRecursive(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE handle = FindFirstFileA((directory + "/*").c_str(), &findData);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        std::string name = findData.cFileName;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = directory + '/' + name;
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFilesRecursive(path, files);
+        else
+            files.push_back(path);
+    } while (FindNextFileA(handle, &findData));
+    FindClose(handle);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent* entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = directory + '/' + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            listFilesRecursive(path, files);
+        else
+            files.push_back(path);
+    }
+    closedir(dir);
+#endif
+}
+#endif
@@ -0,0 +1,121 @@
+#ifndef GGX_SAMPLES_H
+#define GGX_SAMPLES_H
+
+#include <ibl_cache.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// prefilter.fsеHammersleyGGXҪԲֲֻڶȺͲйأ
+// CPUÿֲڶȼһΣRGBA32FɫtexelFetchȡɫвټsqrt/sin/cos
+// ʱGPU決ߺ決IblBakerʹͬһݲʱBRDF LUTҲʹbrdfSamples
+
+const float GGX_PI = 3.14159265359f;
+
+// һԤ˱xyzΪ߿ռ䣨N = (0, 0, 1)V = NLwΪmip
+// BRDFxyzΪN = (0, 0, 1)ʱռHwʹ
+struct GgxSample {
+    float x, y, z, w;
+};
+
+// Van der CorputУɫеRadicalInverse_VdC
+inline float radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// ߿ռеGGXImportanceSampleGGXеH
+inline void ggxHalfVector(uint32_t i, uint32_t sampleCount, float roughness, float h[3])
+{
+    float a = roughness * roughness;
+    float xi0 = float(i) / float(sampleCount), xi1 = radicalInverse(i);
+    float phi = 2.0f * GGX_PI * xi0;
+    float cosTheta = std::sqrt((1.0f - xi1) / (1.0f + (a * a - 1.0f) * xi1));
+    float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+    h[0] = std::cos(phi) * sinTheta;
+    h[1] = std::sin(phi) * sinTheta;
+    h[2] = cosTheta;
+}
+
+// Ԥ˵levelĲֲڶΪ0ʱвL = N1͹
+// ༶ÿһֲڶȲ루prefilterMinSampleCountԽխ
+// pdfѡmipԽֲϡ裬ֲڵһprefilterSampleCount
+// prefilterMinSampleCountСprefilterSampleCountʱмͬԭɫ
+inline uint32_t prefilterSampleCount(const IblBakeParams& params, uint32_t level)
+{
+    if (params.prefilterMinSampleCount >= params.prefilterSampleCount)
+        return params.prefilterSampleCount;
+    if (level == 0 || params.prefilterMipLevels <= 1)
+        return 1;
+    uint32_t shift = std::min(params.prefilterMipLevels - 1 - level, 31u);
+    return std::max(params.prefilterMinSampleCount, params.prefilterSampleCount >> shift);
+}
+
+// prefilter.fsĲֻNdotL > 0ĲԽûйףNdotLL.z
+// mippdfͲ㣬ɫеresolutionΪͼ0ĳߴ
+inline std::vector<GgxSample> prefilterSamples(float roughness, uint32_t sampleCount, uint32_t environmentSize)
+{
+    std::vector<GgxSample> samples;
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float resolution = static_cast<float>(environmentSize);
+    float saTexel = 4.0f * GGX_PI / (6.0f * resolution * resolution);
+    for (uint32_t i = 0; i < sampleCount; i++)
+    {
+        float h[3];
+        ggxHalfVector(i, sampleCount, roughness, h);
+        // L = 2 * dot(V, H) * H - VV = N = (0, 0, 1)
+        float lx = 2.0f * h[2] * h[0], ly = 2.0f * h[2] * h[1], lz = 2.0f * h[2] * h[2] - 1.0f;
+        if (lz <= 0.0f)
+            continue;
+        float nDotH = std::max(h[2], 0.0f);
+        float denominator = nDotH * nDotH * (a2 - 1.0f) + 1.0f;
+        float d = a2 / (GGX_PI * denominator * denominator);
+        float pdf = d * nDotH / (4.0f * nDotH) + 0.0001f;
+        float saSample = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+        float lod = roughness == 0.0f ? 0.0f : 0.5f * std::log2(saSample / saTexel);
+        samples.push_back(GgxSample{ lx, ly, lz, lod });
+    }
+    return samples;
+}
+
+// BRDFֵĲԭbrdf.fsN = (0, 0, 1)ʱImportanceSampleGGX߿ռΪtangent = (0, -1, 0)bitangent = (1, 0, 0)
+// ռH = (H.y, -H.x, H.z)
+inline std::vector<GgxSample> brdfSamples(float roughness, uint32_t sampleCount)
+{
+    std::vector<GgxSample> samples(sampleCount);
+    for (uint32_t i = 0; i < sampleCount; i++)
+    {
+        float h[3];
+        ggxHalfVector(i, sampleCount, roughness, h);
+        samples[i] = GgxSample{ h[1], -h[0], h[2], 0.0f };
+    }
+    return samples;
+}
+
+// Ԥ˲levelΪlevelĲΪЧcountsΪЧ
+inline std::vector<GgxSample> prefilterSampleTable(const IblBakeParams& params, uint32_t& width, std::vector<uint32_t>& counts)
+{
+    std::vector<std::vector<GgxSample>> levels(params.prefilterMipLevels);
+    width = 1;
+    counts.assign(params.prefilterMipLevels, 0);
+    for (uint32_t level = 0; level < params.prefilterMipLevels; level++)
+    {
+        float roughness = params.prefilterMipLevels > 1 ? (float)level / (float)(params.prefilterMipLevels - 1) : 0.0f;
+        levels[level] = prefilterSamples(roughness, prefilterSampleCount(params, level), params.environmentSize);
+        counts[level] = static_cast<uint32_t>(levels[level].size());
+        width = std::max(width, counts[level]);
+    }
+    std::vector<GgxSample> table((size_t)width * params.prefilterMipLevels, GgxSample{ 0.0f, 0.0f, 1.0f, 0.0f });
+    for (uint32_t level = 0; level < params.prefilterMipLevels; level++)
+        std::copy(levels[level].begin(), levels[level].end(), table.begin() + (size_t)level * width);
+    return table;
+}
+#endif
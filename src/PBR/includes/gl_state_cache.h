@@ -0,0 +1,156 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+
+// ÿ֡״̬лͳƣissuedΪʵʷGLfilteredΪ뵱ǰ״̬ͬʡȥĵ
+struct GLStateStats {
+    unsigned int issued = 0;
+    unsigned int filtered = 0;
+};
+
+// ######################################
+// # Class GLStateCache
+// ######################################
+// ¼ǰ󶨵ĳVAOԪ֡壬󶨵Ķ¼ͬʱٵGL
+// ֻоİ󶨲Żᱻ¼غʽϴֱӵglBindTextureĴ֮֡У
+// beginFrame()ʱԪļ¼VAOİȫImGuiƺָԭİ󶨣
+class GLStateCache
+{
+public:
+    static GLStateCache& instance()
+    {
+        static GLStateCache cache;
+        return cache;
+    }
+
+    void useProgram(unsigned int program)
+    {
+        if (filter(currentProgram, program))
+            return;
+        glUseProgram(program);
+    }
+
+    void bindVertexArray(unsigned int vertexArray)
+    {
+        if (filter(currentVertexArray, vertexArray))
+            return;
+        glBindVertexArray(vertexArray);
+    }
+
+    // texture󶨵Ԫunit0ʼtargetϣҪʱлǰԪ
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture)
+    {
+        int slot = targetSlot(target);
+        if (unit < MAX_TEXTURE_UNITS && slot >= 0 && filter(textures[unit][slot], texture))
+            return;
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        if (slot < 0)
+            current.issued++;
+    }
+
+    // GL_FRAMEBUFFERͬʱûƺͶȡ֡
+    void bindFramebuffer(GLenum target, unsigned int framebuffer)
+    {
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        if ((!draw || drawFramebuffer == framebuffer) && (!read || readFramebuffer == framebuffer))
+        {
+            current.filtered++;
+            return;
+        }
+        if (draw)
+            drawFramebuffer = framebuffer;
+        if (read)
+            readFramebuffer = framebuffer;
+        current.issued++;
+        glBindFramebuffer(target, framebuffer);
+    }
+
+    // ֡ʼʱãһ֡ͳƣԪļ¼
+    void beginFrame()
+    {
+        last = current;
+        current = GLStateStats();
+        invalidateTextures();
+    }
+
+    // ȫ¼֮ÿ󶨶ʵʷڲֱ޸˳VAO֡󶨵Ĵ֮
+    void invalidate()
+    {
+        currentProgram = UNKNOWN;
+        currentVertexArray = UNKNOWN;
+        drawFramebuffer = UNKNOWN;
+        readFramebuffer = UNKNOWN;
+        invalidateTextures();
+    }
+
+    void invalidateTextures()
+    {
+        activeUnit = UNKNOWN;
+        for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            for (unsigned int slot = 0; slot < TARGET_SLOTS; slot++)
+                textures[unit][slot] = UNKNOWN;
+    }
+
+    // һ֡ͳ
+    const GLStateStats& lastFrameStats() const
+    {
+        return last;
+    }
+
+private:
+    static const unsigned int UNKNOWN = 0xFFFFFFFFu;
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+    static const unsigned int TARGET_SLOTS = 3;
+
+    unsigned int currentProgram;
+    unsigned int currentVertexArray;
+    unsigned int drawFramebuffer;
+    unsigned int readFramebuffer;
+    unsigned int activeUnit;
+    unsigned int textures[MAX_TEXTURE_UNITS][TARGET_SLOTS];
+    GLStateStats current;
+    GLStateStats last;
+
+    GLStateCache()
+    {
+        invalidate();
+    }
+
+    // ¼ͬʱΪʡȥtrue¼¼Ϊ
+    bool filter(unsigned int& cached, unsigned int value)
+    {
+        if (cached == value)
+        {
+            current.filtered++;
+            return true;
+        }
+        cached = value;
+        current.issued++;
+        return false;
+    }
+
+    void activeTexture(unsigned int unit)
+    {
+        if (activeUnit == unit)
+            return;
+        activeUnit = unit;
+        current.issued++;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // ¼Ŀ꣬ĿİǷ
+    static int targetSlot(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        default: return -1;
+        }
+    }
+};
+#endif
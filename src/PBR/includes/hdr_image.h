@@ -0,0 +1,332 @@
+#ifndef HDR_IMAGE_H
+#define HDR_IMAGE_H
+
+#include <mapped_file.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+// Radiance HDR.hdrRGBEӳļ˳ɨһõÿɨߵʼλã
+// ̳߳внRLEɨߣһתΪ뾫RGBRGB9E532λмͼ
+
+// ظʽ
+enum HdrPixelFormat {
+    HDR_PIXELS_RGB16F,  // 3뾫ȸ㣬ÿ6ֽڣӦGL_RGB16F / GL_HALF_FLOAT
+    HDR_PIXELS_RGB9E5   // ָÿ4ֽڣӦGL_RGB9_E5 / GL_UNSIGNED_INT_5_9_9_9_REV
+};
+
+struct HdrImage {
+    int width = 0;
+    int height = 0;
+    HdrPixelFormat format = HDR_PIXELS_RGB16F;
+    std::vector<unsigned char> pixels;
+    // νʱ룩ͳ
+    double decodeMs = 0.0;
+};
+
+inline size_t hdrPixelBytes(HdrPixelFormat format)
+{
+    return format == HDR_PIXELS_RGB9E5 ? 4 : 6;
+}
+
+// 32λת뾫ȣͽ뵽żΪ
+inline uint16_t floatToHalf(float value)
+{
+    const uint32_t infinity32 = 255u << 23;
+    const uint32_t halfOverflow = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t result;
+    if (bits >= halfOverflow)
+        result = bits > infinity32 ? 0x7e00 : 0x7c00;
+    else if (bits < (113u << 23))
+    {
+        // ǹӷλ
+        float magic, sum;
+        memcpy(&magic, &denormMagic, 4);
+        memcpy(&sum, &bits, 4);
+        sum += magic;
+        uint32_t sumBits;
+        memcpy(&sumBits, &sum, 4);
+        result = static_cast<uint16_t>(sumBits - denormMagic);
+    }
+    else
+    {
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += (uint32_t)(15 - 127) << 23;
+        bits += 0xfff + mantissaOdd;
+        result = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+// 뾫ת32λ
+inline float halfToFloat(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else
+    {
+        // ǹ2^-24
+        float result = mantissa * (1.0f / 16777216.0f);
+        return sign ? -result : result;
+    }
+    float result;
+    memcpy(&result, &bits, 4);
+    return result;
+}
+
+// EXT_texture_shared_exponent淶ѷǸRGBΪRGB9E5
+inline uint32_t packRGB9E5(float r, float g, float b)
+{
+    const int mantissaBits = 9;
+    const int bias = 15;
+    const float maxValue = 65408.0f;   // (2^9 - 1) / 2^9 * 2^(31 - 15)
+    r = std::min(std::max(r, 0.0f), maxValue);
+    g = std::min(std::max(g, 0.0f), maxValue);
+    b = std::min(std::max(b, 0.0f), maxValue);
+    float maxComponent = std::max(r, std::max(g, b));
+    int exponent;
+    std::frexp(maxComponent, &exponent);   // maxComponent = m * 2^exponentm[0.5, 1)floor(log2) = exponent - 1
+    int sharedExponent = std::max(-bias - 1, exponent - 1) + 1 + bias;
+    float scale = std::ldexp(1.0f, sharedExponent - bias - mantissaBits);
+    if ((int)std::floor(maxComponent / scale + 0.5f) == (1 << mantissaBits))
+    {
+        sharedExponent++;
+        scale *= 2.0f;
+    }
+    uint32_t rs = (uint32_t)std::floor(r / scale + 0.5f);
+    uint32_t gs = (uint32_t)std::floor(g / scale + 0.5f);
+    uint32_t bs = (uint32_t)std::floor(b / scale + 0.5f);
+    return rs | (gs << 9) | (bs << 18) | ((uint32_t)sharedExponent << 27);
+}
+
+// RGBEָӦϵstb_imageͬvalue = mantissa * 2^(e - 136)
+inline const float* rgbeScaleTable()
+{
+    struct Table {
+        float scale[256];
+        Table()
+        {
+            scale[0] = 0.0f;
+            for (int e = 1; e < 256; e++)
+                scale[e] = std::ldexp(1.0f, e - (128 + 8));
+        }
+    };
+    static const Table table;
+    return table.scale;
+}
+
+// һɨΪRGBErleΪtrueʱΪʽRLEÿֱͨγ̱룩Ϊδѹ4ֽ
+inline bool decodeHdrScanline(const unsigned char* data, const unsigned char* end, int width, bool rle, unsigned char* rgbe)
+{
+    if (!rle)
+    {
+        if (end - data < (ptrdiff_t)width * 4)
+            return false;
+        memcpy(rgbe, data, (size_t)width * 4);
+        return true;
+    }
+    data += 4;
+    for (int channel = 0; channel < 4; channel++)
+    {
+        int x = 0;
+        while (x < width)
+        {
+            if (data >= end)
+                return false;
+            int count = *data++;
+            if (count > 128)
+            {
+                count -= 128;
+                if (count > width - x || data >= end)
+                    return false;
+                unsigned char value = *data++;
+                for (int i = 0; i < count; i++)
+                    rgbe[(x++) * 4 + channel] = value;
+            }
+            else
+            {
+                if (count == 0 || count > width - x || end - data < count)
+                    return false;
+                for (int i = 0; i < count; i++)
+                    rgbe[(x++) * 4 + channel] = *data++;
+            }
+        }
+    }
+    return true;
+}
+
+// һʽRLEɨߣһʼλãʱnullptr
+inline const unsigned char* skipHdrScanline(const unsigned char* data, const unsigned char* end, int width)
+{
+    if (end - data < 4)
+        return nullptr;
+    data += 4;
+    for (int channel = 0; channel < 4; channel++)
+    {
+        int x = 0;
+        while (x < width)
+        {
+            if (data >= end)
+                return nullptr;
+            int count = *data++;
+            if (count > 128)
+            {
+                x += count - 128;
+                data++;
+            }
+            else
+            {
+                if (count == 0)
+                    return nullptr;
+                x += count;
+                data += count;
+            }
+            if (x > width || data > end)
+                return nullptr;
+        }
+    }
+    return data;
+}
+
+// .hdrļֻ֧"-Y H +X W"϶£"+Y H +X W"¶ϣַ
+// ԼʽRLEfalse߿˻stb_imagepoolΪʱɨ߷鲢н
+inline bool decodeHdrImage(const std::string& path, HdrPixelFormat format, bool flipVertically, HdrImage& image, ThreadPool* pool = nullptr)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    image = HdrImage();
+    image.format = format;
+
+    MappedFile file(path);
+    if (!file.isOpen())
+        return false;
+    const unsigned char* data = file.data();
+    const unsigned char* end = data + file.size();
+
+    // ļͷ"#?RADIANCE""#?RGBE"ͷбУȻǷֱ
+    auto readLine = [&](std::string& line) {
+        line.clear();
+        while (data < end && *data != '\n')
+            line += static_cast<char>(*data++);
+        if (data >= end)
+            return false;
+        data++;
+        return true;
+    };
+    std::string line;
+    if (!readLine(line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+        return false;
+    bool validFormat = false;
+    for (;;)
+    {
+        if (!readLine(line))
+            return false;
+        if (line.empty())
+            break;
+        if (line == "FORMAT=32-bit_rle_rgbe")
+            validFormat = true;
+    }
+    if (!validFormat || !readLine(line))
+        return false;
+    char ySign, xSign;
+    int width, height;
+    if (sscanf(line.c_str(), "%cY %d %cX %d", &ySign, &height, &xSign, &width) != 4 || xSign != '+' || (ySign != '-' && ySign != '+'))
+        return false;
+    if (width <= 0 || height <= 0)
+        return false;
+    // ļеĵһɨ߶Ӧͼ񶥲-Yײ+Y
+    bool bottomUp = ySign == '+';
+
+    // stb_imageͬɵһɨжͼǷΪʽRLE
+    bool rle = width >= 8 && width < 32768 && end - data >= 4 && data[0] == 2 && data[1] == 2 && !(data[2] & 0x80);
+    std::vector<const unsigned char*> scanlines(height);
+    for (int y = 0; y < height; y++)
+    {
+        scanlines[y] = data;
+        data = rle ? skipHdrScanline(data, end, width) : data + (size_t)width * 4;
+        if (!data || data > end)
+            return false;
+    }
+
+    image.width = width;
+    image.height = height;
+    size_t pixelBytes = hdrPixelBytes(format);
+    image.pixels.resize((size_t)width * height * pixelBytes);
+    const float* scales = rgbeScaleTable();
+    bool flipRows = flipVertically != bottomUp;
+
+    // [first, last)ɨ߲תĿʽ
+    auto decodeRows = [&](int first, int last) {
+        std::vector<unsigned char> rgbe((size_t)width * 4);
+        for (int y = first; y < last; y++)
+        {
+            if (!decodeHdrScanline(scanlines[y], end, width, rle, rgbe.data()))
+                return false;
+            int row = flipRows ? height - 1 - y : y;
+            unsigned char* out = image.pixels.data() + (size_t)row * width * pixelBytes;
+            for (int x = 0; x < width; x++)
+            {
+                const unsigned char* texel = &rgbe[(size_t)x * 4];
+                float scale = scales[texel[3]];
+                float r = texel[0] * scale, g = texel[1] * scale, b = texel[2] * scale;
+                if (format == HDR_PIXELS_RGB9E5)
+                {
+                    uint32_t packed = packRGB9E5(r, g, b);
+                    memcpy(out + (size_t)x * 4, &packed, 4);
+                }
+                else
+                {
+                    uint16_t half[3] = { floatToHalf(r), floatToHalf(g), floatToHalf(b) };
+                    memcpy(out + (size_t)x * 6, half, 6);
+                }
+            }
+        }
+        return true;
+    };
+
+    bool decoded = true;
+    if (pool && pool->size() > 1)
+    {
+        // ÿɨʹԼΪ߳4ڸؾ
+        int rowsPerTask = std::max(1, height / (int)(pool->size() * 4));
+        std::vector<std::future<bool>> tasks;
+        for (int first = 0; first < height; first += rowsPerTask)
+        {
+            int last = std::min(height, first + rowsPerTask);
+            tasks.push_back(pool->enqueue([&decodeRows, first, last] { return decodeRows(first, last); }));
+        }
+        for (size_t i = 0; i < tasks.size(); i++)
+            decoded = tasks[i].get() && decoded;
+    }
+    else
+        decoded = decodeRows(0, height);
+    if (!decoded)
+    {
+        image = HdrImage();
+        return false;
+    }
+
+    image.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+#endif
@@ -0,0 +1,533 @@
+#ifndef IBL_BAKER_H
+#define IBL_BAKER_H
+
+#include <hdr_image.h>
+#include <ggx_samples.h>
+#include <ibl_cache.h>
+#include <spherical_harmonics.h>
+#include <work_stealing_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IBL_BAKER_SSE 1
+#include <emmintrin.h>
+#endif
+
+// IBLԤCPUʵ֣ҪGLġequirectangular_to_cubemap.fsprefilter.fs
+// ɫеĳ߿ռĹ췽ʽԼGLͼԼ޷ˣնгϵͶӰʱͬ
+// дʱGPU決ͬ.iblcacheʱֱл档BRDFֲұҲ㣬ڹʱɲǶ
+// GPU決ggx_samples.hԤȼĲ
+// ڵѭֻʣ·任ͼͶӰȡǰSSEһδ4
+
+// 32λRGBͼ
+struct IblImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+};
+
+// 32λRGBͼmipÿһ6
+struct IblCubeMap {
+    int size = 0;
+    std::vector<std::vector<float>> levels;
+
+    int levelSize(int level) const
+    {
+        return std::max(1, size >> level);
+    }
+
+    float* face(int level, int face)
+    {
+        return levels[level].data() + (size_t)face * levelSize(level) * levelSize(level) * 3;
+    }
+
+    const float* face(int level, int face) const
+    {
+        return levels[level].data() + (size_t)face * levelSize(level) * levelSize(level) * 3;
+    }
+
+    void allocate(int faceSize, int levelCount)
+    {
+        size = faceSize;
+        levels.assign(levelCount, std::vector<float>());
+        for (int level = 0; level < levelCount; level++)
+            levels[level].assign((size_t)6 * levelSize(level) * levelSize(level) * 3, 0.0f);
+    }
+};
+
+// HDRʱֱͬת뾫ȣչΪ32λ㣬ʹCPU決ֵGPUϵһ
+inline bool loadIblSource(const std::string& path, IblImage& image, ThreadPool* pool = nullptr)
+{
+    HdrImage hdr;
+    if (!decodeHdrImage(path, HDR_PIXELS_RGB16F, true, hdr, pool))
+        return false;
+    image.width = hdr.width;
+    image.height = hdr.height;
+    image.pixels.resize((size_t)hdr.width * hdr.height * 3);
+    const uint16_t* halves = reinterpret_cast<const uint16_t*>(hdr.pixels.data());
+    for (size_t i = 0; i < image.pixels.size(); i++)
+        image.pixels[i] = halfToFloat(halves[i]);
+    return true;
+}
+
+// ͶӰͼs/t[0, 1]
+inline int cubeFaceCoords(float x, float y, float z, float& s, float& t)
+{
+    float ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+    int face;
+    float ma, sc, tc;
+    if (ax >= ay && ax >= az)
+    {
+        face = x > 0.0f ? 0 : 1;
+        ma = ax;
+        sc = x > 0.0f ? -z : z;
+        tc = -y;
+    }
+    else if (ay >= az)
+    {
+        face = y > 0.0f ? 2 : 3;
+        ma = ay;
+        sc = x;
+        tc = y > 0.0f ? z : -z;
+    }
+    else
+    {
+        face = z > 0.0f ? 4 : 5;
+        ma = az;
+        sc = z > 0.0f ? x : -x;
+        tc = -y;
+    }
+    s = 0.5f * (sc / ma + 1.0f);
+    t = 0.5f * (tc / ma + 1.0f);
+    return face;
+}
+
+// ȡһأ߽ʱͶӰڵ棨ӦGL_TEXTURE_CUBE_MAP_SEAMLESS
+inline const float* cubeTexel(const IblCubeMap& map, int level, int face, int x, int y)
+{
+    int size = map.levelSize(level);
+    if (x < 0 || y < 0 || x >= size || y >= size)
+    {
+        float direction[3], s, t;
+        cubeTexelDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f, direction);
+        face = cubeFaceCoords(direction[0], direction[1], direction[2], s, t);
+        x = std::min(std::max(static_cast<int>(s * size), 0), size - 1);
+        y = std::min(std::max(static_cast<int>(t * size), 0), size - 1);
+    }
+    return map.face(level, face) + ((size_t)y * size + x) * 3;
+}
+
+// ĳһĳ˫ԲۼweightĽ
+inline void accumulateCubeBilinear(const IblCubeMap& map, int level, int face, float s, float t, float weight, float result[3])
+{
+    int size = map.levelSize(level);
+    float u = s * size - 0.5f, v = t * size - 0.5f;
+    int x0 = static_cast<int>(std::floor(u)), y0 = static_cast<int>(std::floor(v));
+    float fx = u - x0, fy = v - y0;
+    const float* texels[4] = { cubeTexel(map, level, face, x0, y0), cubeTexel(map, level, face, x0 + 1, y0),
+                               cubeTexel(map, level, face, x0, y0 + 1), cubeTexel(map, level, face, x0 + 1, y0 + 1) };
+    float weights[4] = { (1.0f - fx) * (1.0f - fy) * weight, fx * (1.0f - fy) * weight, (1.0f - fx) * fy * weight, fx * fy * weight };
+    for (int i = 0; i < 4; i++)
+    {
+        result[0] += texels[i][0] * weights[i];
+        result[1] += texels[i][1] * weights[i];
+        result[2] += texels[i][2] * weights[i];
+    }
+}
+
+// ԲtextureLodGL_LINEAR_MIPMAP_LINEARlodеļڣۼweightĽ
+inline void accumulateCubeLod(const IblCubeMap& map, int face, float s, float t, float lod, float weight, float result[3])
+{
+    int maxLevel = static_cast<int>(map.levels.size()) - 1;
+    lod = std::min(std::max(lod, 0.0f), static_cast<float>(maxLevel));
+    int level = static_cast<int>(lod);
+    float fraction = lod - level;
+    if (fraction > 0.0f && level < maxLevel)
+    {
+        accumulateCubeBilinear(map, level, face, s, t, weight * (1.0f - fraction), result);
+        accumulateCubeBilinear(map, level + 1, face, s, t, weight * fraction, result);
+    }
+    else
+        accumulateCubeBilinear(map, level, face, s, t, weight, result);
+}
+
+// Ⱦȫͼ˫ԲGL_CLAMP_TO_EDGEѹһ
+inline void sampleEquirect(const IblImage& image, float x, float y, float z, float result[3])
+{
+    // ɫеinvAtanһ
+    float u = std::atan2(z, x) * 0.1591f + 0.5f;
+    float v = std::asin(std::min(std::max(y, -1.0f), 1.0f)) * 0.3183f + 0.5f;
+    float px = std::min(std::max(u * image.width - 0.5f, 0.0f), image.width - 1.0f);
+    float py = std::min(std::max(v * image.height - 0.5f, 0.0f), image.height - 1.0f);
+    int x0 = static_cast<int>(px), y0 = static_cast<int>(py);
+    int x1 = std::min(x0 + 1, image.width - 1), y1 = std::min(y0 + 1, image.height - 1);
+    float fx = px - x0, fy = py - y0;
+    const float* p00 = &image.pixels[((size_t)y0 * image.width + x0) * 3];
+    const float* p10 = &image.pixels[((size_t)y0 * image.width + x1) * 3];
+    const float* p01 = &image.pixels[((size_t)y1 * image.width + x0) * 3];
+    const float* p11 = &image.pixels[((size_t)y1 * image.width + x1) * 3];
+    for (int c = 0; c < 3; c++)
+    {
+        float top = p00[c] + (p10[c] - p00[c]) * fx;
+        float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+        result[c] = top + (bottom - top) * fy;
+    }
+}
+
+// ߿ռеһȨغͲmipSoAȲ뵽4ı벿ȨΪ0
+struct IblSampleSet {
+    std::vector<float> x, y, z;
+    std::vector<float> weight;
+    std::vector<float> lod;
+    float scale = 1.0f;     // Ȩͳscaleõ
+
+    void add(float sx, float sy, float sz, float sampleWeight, float sampleLod)
+    {
+        x.push_back(sx);
+        y.push_back(sy);
+        z.push_back(sz);
+        weight.push_back(sampleWeight);
+        lod.push_back(sampleLod);
+    }
+
+    void pad()
+    {
+        while (x.size() % 4 != 0)
+            add(0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+    }
+};
+
+// prefilter.fslevelĲGPU決ʹͬһݲggx_samples.hȨΪNdotL
+inline IblSampleSet prefilterSampleSet(uint32_t level, const IblBakeParams& params)
+{
+    IblSampleSet samples;
+    float roughness = params.prefilterMipLevels > 1 ? (float)level / (float)(params.prefilterMipLevels - 1) : 0.0f;
+    float totalWeight = 0.0f;
+    for (const GgxSample& sample : prefilterSamples(roughness, prefilterSampleCount(params, level), params.environmentSize))
+    {
+        samples.add(sample.x, sample.y, sample.z, sample.z, sample.w);
+        totalWeight += sample.z;
+    }
+    samples.scale = totalWeight > 0.0f ? 1.0f / totalWeight : 0.0f;
+    samples.pad();
+    return samples;
+}
+
+inline void normalize3(float v[3])
+{
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= length;
+    v[1] /= length;
+    v[2] /= length;
+}
+
+inline void cross3(const float a[3], const float b[3], float result[3])
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// ImportanceSampleGGX߿ռ
+inline void ggxFrame(const float n[3], float tangent[3], float bitangent[3])
+{
+    const float upZ[3] = { 0.0f, 0.0f, 1.0f };
+    const float upX[3] = { 1.0f, 0.0f, 0.0f };
+    cross3(std::fabs(n[2]) < 0.999f ? upZ : upX, n, tangent);
+    normalize3(tangent);
+    cross3(n, tangent, bitangent);
+}
+
+// ߿ռĲ任(tangent, bitangent, n)£ͼȨ
+inline void integrateCubeSamples(const IblCubeMap& map, const float tangent[3], const float bitangent[3], const float n[3],
+                                 const IblSampleSet& samples, bool simd, float result[3])
+{
+    float sum[3] = { 0.0f, 0.0f, 0.0f };
+    size_t count = samples.x.size();
+#ifdef IBL_BAKER_SSE
+    if (simd)
+    {
+        // 任ѡ4һ飬ȡ
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        auto select = [](__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+        for (size_t i = 0; i < count; i += 4)
+        {
+            __m128 sx = _mm_loadu_ps(&samples.x[i]), sy = _mm_loadu_ps(&samples.y[i]), sz = _mm_loadu_ps(&samples.z[i]);
+            __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(tangent[0])), _mm_mul_ps(sy, _mm_set1_ps(bitangent[0]))), _mm_mul_ps(sz, _mm_set1_ps(n[0])));
+            __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(tangent[1])), _mm_mul_ps(sy, _mm_set1_ps(bitangent[1]))), _mm_mul_ps(sz, _mm_set1_ps(n[1])));
+            __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(tangent[2])), _mm_mul_ps(sy, _mm_set1_ps(bitangent[2]))), _mm_mul_ps(sz, _mm_set1_ps(n[2])));
+            __m128 ax = _mm_andnot_ps(signMask, x), ay = _mm_andnot_ps(signMask, y), az = _mm_andnot_ps(signMask, z);
+            __m128 majorX = _mm_and_ps(_mm_cmpge_ps(ax, ay), _mm_cmpge_ps(ax, az));
+            __m128 majorY = _mm_andnot_ps(majorX, _mm_cmpge_ps(ay, az));
+            __m128 majorZ = _mm_andnot_ps(_mm_or_ps(majorX, majorY), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+            __m128 xPositive = _mm_cmpgt_ps(x, zero), yPositive = _mm_cmpgt_ps(y, zero), zPositive = _mm_cmpgt_ps(z, zero);
+            __m128 negX = _mm_xor_ps(x, signMask), negY = _mm_xor_ps(y, signMask), negZ = _mm_xor_ps(z, signMask);
+
+            __m128 ma = select(majorX, ax, select(majorY, ay, az));
+            __m128 sc = select(majorX, select(xPositive, negZ, z), select(majorY, x, select(zPositive, x, negX)));
+            __m128 tc = select(majorY, select(yPositive, z, negZ), negY);
+            __m128 faceX = select(xPositive, zero, one);
+            __m128 faceY = _mm_add_ps(_mm_set1_ps(2.0f), select(yPositive, zero, one));
+            __m128 faceZ = _mm_add_ps(_mm_set1_ps(4.0f), select(zPositive, zero, one));
+            __m128 face = _mm_or_ps(_mm_and_ps(majorX, faceX), _mm_or_ps(_mm_and_ps(majorY, faceY), _mm_and_ps(majorZ, faceZ)));
+            __m128 inverseMa = _mm_div_ps(one, ma);
+            __m128 s = _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(sc, inverseMa), one));
+            __m128 t = _mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(tc, inverseMa), one));
+
+            alignas(16) float faces[4], ss[4], ts[4];
+            _mm_store_ps(faces, face);
+            _mm_store_ps(ss, s);
+            _mm_store_ps(ts, t);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float weight = samples.weight[i + lane];
+                if (weight != 0.0f)
+                    accumulateCubeLod(map, static_cast<int>(faces[lane]), ss[lane], ts[lane], samples.lod[i + lane], weight, sum);
+            }
+        }
+    }
+    else
+#endif
+    {
+        (void)simd;
+        for (size_t i = 0; i < count; i++)
+        {
+            float weight = samples.weight[i];
+            if (weight == 0.0f)
+                continue;
+            float x = samples.x[i] * tangent[0] + samples.y[i] * bitangent[0] + samples.z[i] * n[0];
+            float y = samples.x[i] * tangent[1] + samples.y[i] * bitangent[1] + samples.z[i] * n[1];
+            float z = samples.x[i] * tangent[2] + samples.y[i] * bitangent[2] + samples.z[i] * n[2];
+            float s, t;
+            int face = cubeFaceCoords(x, y, z, s, t);
+            accumulateCubeLod(map, face, s, t, samples.lod[i], weight, sum);
+        }
+    }
+    result[0] = sum[0] * samples.scale;
+    result[1] = sum[1] * samples.scale;
+    result[2] = sum[2] * samples.scale;
+}
+
+// ͼĳһĳĵĹһ
+inline void cubeTexelNormal(int face, int x, int y, int size, float n[3])
+{
+    cubeTexelDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f, n);
+    normalize3(n);
+}
+
+// ȾȫͼתΪͼequirectangular_to_cubemap.fs2x2ʽ˲mipglGenerateMipmap
+inline void bakeEnvironmentCube(const IblImage& source, int size, WorkStealingPool& pool, IblCubeMap& environment)
+{
+    int levelCount = 1;
+    while ((size >> levelCount) > 0)
+        levelCount++;
+    environment.allocate(size, levelCount);
+    pool.parallelFor((size_t)6 * size, 4, [&](size_t first, size_t last) {
+        for (size_t row = first; row < last; row++)
+        {
+            int face = static_cast<int>(row / size), y = static_cast<int>(row % size);
+            float* out = environment.face(0, face) + (size_t)y * size * 3;
+            for (int x = 0; x < size; x++)
+            {
+                float n[3];
+                cubeTexelNormal(face, x, y, size, n);
+                sampleEquirect(source, n[0], n[1], n[2], out + (size_t)x * 3);
+            }
+        }
+    });
+    for (int level = 1; level < levelCount; level++)
+    {
+        int levelSize = environment.levelSize(level), parentSize = environment.levelSize(level - 1);
+        pool.parallelFor((size_t)6 * levelSize, 16, [&](size_t first, size_t last) {
+            for (size_t row = first; row < last; row++)
+            {
+                int face = static_cast<int>(row / levelSize), y = static_cast<int>(row % levelSize);
+                const float* parent = environment.face(level - 1, face);
+                float* out = environment.face(level, face) + (size_t)y * levelSize * 3;
+                for (int x = 0; x < levelSize; x++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        out[x * 3 + c] = 0.25f * (parent[((size_t)(2 * y) * parentSize + 2 * x) * 3 + c] + parent[((size_t)(2 * y) * parentSize + 2 * x + 1) * 3 + c]
+                                                + parent[((size_t)(2 * y + 1) * parentSize + 2 * x) * 3 + c] + parent[((size_t)(2 * y + 1) * parentSize + 2 * x + 1) * 3 + c]);
+                    }
+                }
+            }
+        });
+    }
+}
+
+// նгϵʱreadIrradianceSH()ͬͶӰͼгߴΪshProjectionSizemip
+inline IrradianceSH projectEnvironmentSH(const IblCubeMap& environment, const IblBakeParams& params, bool simd)
+{
+    int level = 0;
+    while (level + 1 < static_cast<int>(environment.levels.size()) && environment.levelSize(level + 1) >= static_cast<int>(params.shProjectionSize))
+        level++;
+    const float* faces[6];
+    for (int face = 0; face < 6; face++)
+        faces[face] = environment.face(level, face);
+    return projectIrradianceSH(faces, environment.levelSize(level), simd);
+}
+
+// 淴Ԥˣprefilter.fsmipĴֲڶΪmip / (prefilterMipLevels - 1)
+// мطͬһparallelForУÿصĲͬɹȡƽ
+inline void bakePrefilter(const IblCubeMap& environment, const IblBakeParams& params, WorkStealingPool& pool, bool simd, IblCubeMap& prefilter)
+{
+    int levelCount = static_cast<int>(params.prefilterMipLevels);
+    prefilter.allocate(static_cast<int>(params.prefilterSize), levelCount);
+    std::vector<IblSampleSet> samples(levelCount);
+    std::vector<size_t> levelStart(levelCount + 1, 0);
+    for (int level = 0; level < levelCount; level++)
+    {
+        samples[level] = prefilterSampleSet(level, params);
+        levelStart[level + 1] = levelStart[level] + (size_t)6 * prefilter.levelSize(level) * prefilter.levelSize(level);
+    }
+    pool.parallelFor(levelStart[levelCount], 8, [&](size_t first, size_t last) {
+        for (size_t index = first; index < last; index++)
+        {
+            int level = 0;
+            while (index >= levelStart[level + 1])
+                level++;
+            int size = prefilter.levelSize(level);
+            size_t texel = index - levelStart[level];
+            int face = static_cast<int>(texel / ((size_t)size * size));
+            int y = static_cast<int>(texel / size % size), x = static_cast<int>(texel % size);
+            float n[3], tangent[3], bitangent[3];
+            cubeTexelNormal(face, x, y, size, n);
+            ggxFrame(n, tangent, bitangent);
+            integrateCubeSamples(environment, tangent, bitangent, n, samples[level], simd, prefilter.face(level, face) + ((size_t)y * size + x) * 3);
+        }
+    });
+}
+
+// BRDFֲұһУLearnOpenGLbrdf.fsroughness̶NdotVб仯Hggx_samples.hеbrdfSamples
+inline void integrateBrdfRow(float roughness, int size, uint32_t sampleCount, bool simd, float* out)
+{
+    // V.y = 0ҪHy
+    std::vector<float> hx(sampleCount), hz(sampleCount);
+    std::vector<GgxSample> samples = brdfSamples(roughness, sampleCount);
+    for (uint32_t i = 0; i < sampleCount; i++)
+    {
+        hx[i] = samples[i].x;
+        hz[i] = samples[i].z;
+    }
+    float k = (roughness * roughness) / 2.0f;
+
+    for (int column = 0; column < size; column++)
+    {
+        float nDotV = (column + 0.5f) / size;
+        float vx = std::sqrt(1.0f - nDotV * nDotV), vz = nDotV;
+        float g1V = nDotV / (nDotV * (1.0f - k) + k);
+        float sumA = 0.0f, sumB = 0.0f;
+        uint32_t i = 0;
+#ifdef IBL_BAKER_SSE
+        if (simd)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 two = _mm_set1_ps(2.0f);
+            const __m128 kv = _mm_set1_ps(k), oneMinusK = _mm_set1_ps(1.0f - k);
+            const __m128 vxv = _mm_set1_ps(vx), vzv = _mm_set1_ps(vz);
+            const __m128 gv = _mm_set1_ps(g1V / nDotV);
+            __m128 accumulatedA = zero, accumulatedB = zero;
+            for (; i + 4 <= sampleCount; i += 4)
+            {
+                __m128 x = _mm_loadu_ps(&hx[i]), z = _mm_loadu_ps(&hz[i]);
+                __m128 vDotH = _mm_add_ps(_mm_mul_ps(vxv, x), _mm_mul_ps(vzv, z));
+                __m128 lz = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, vDotH), z), vzv);
+                __m128 valid = _mm_cmpgt_ps(lz, zero);
+                __m128 nDotL = _mm_max_ps(lz, zero);
+                __m128 clampedVdotH = _mm_max_ps(vDotH, zero);
+                __m128 nDotH = _mm_max_ps(z, zero);
+                __m128 g1L = _mm_div_ps(nDotL, _mm_add_ps(_mm_mul_ps(nDotL, oneMinusK), kv));
+                // G_Vis = G1(V) * G1(L) * VdotH / (NdotH * NdotV)
+                __m128 gVis = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(gv, g1L), clampedVdotH), nDotH);
+                gVis = _mm_and_ps(valid, gVis);
+                __m128 f = _mm_sub_ps(one, clampedVdotH);
+                __m128 f2 = _mm_mul_ps(f, f);
+                __m128 fc = _mm_mul_ps(_mm_mul_ps(f2, f2), f);
+                accumulatedA = _mm_add_ps(accumulatedA, _mm_mul_ps(_mm_sub_ps(one, fc), gVis));
+                accumulatedB = _mm_add_ps(accumulatedB, _mm_mul_ps(fc, gVis));
+            }
+            alignas(16) float lanesA[4], lanesB[4];
+            _mm_store_ps(lanesA, accumulatedA);
+            _mm_store_ps(lanesB, accumulatedB);
+            sumA = (lanesA[0] + lanesA[1]) + (lanesA[2] + lanesA[3]);
+            sumB = (lanesB[0] + lanesB[1]) + (lanesB[2] + lanesB[3]);
+        }
+#endif
+        (void)simd;
+        for (; i < sampleCount; i++)
+        {
+            float vDotH = vx * hx[i] + vz * hz[i];
+            float lz = 2.0f * vDotH * hz[i] - vz;
+            if (lz <= 0.0f)
+                continue;
+            float nDotL = lz;
+            float clampedVdotH = std::max(vDotH, 0.0f);
+            float nDotH = std::max(hz[i], 0.0f);
+            float g = g1V * (nDotL / (nDotL * (1.0f - k) + k));
+            float gVis = (g * clampedVdotH) / (nDotH * nDotV);
+            float fc = std::pow(1.0f - clampedVdotH, 5.0f);
+            sumA += (1.0f - fc) * gVis;
+            sumB += fc * gVis;
+        }
+        out[column * 2] = sumA / float(sampleCount);
+        out[column * 2 + 1] = sumB / float(sampleCount);
+    }
+}
+
+// BRDFֲұĲLUTκ룬IblBaker --brdf-lutڹʱɲǶ򣨼brdf_lut.h
+// ߴ硢;ȿڹеLUTСȡ
+struct BrdfLutParams {
+    uint32_t size = 512;            // LUTߴ
+    uint32_t sampleCount = 1024;    // ÿصĲ
+    bool halfFloat = true;          // trueʱ԰뾫ȱ沢ϴΪGL_RG16FfalseʱΪGL_RG32F
+};
+
+// BRDFֲұyеĴֲڶΪ(y + 0.5) / sizexеNdotVΪ(x + 0.5) / sizeģ
+inline void bakeBrdfLut(const BrdfLutParams& params, WorkStealingPool& pool, bool simd, std::vector<float>& lut)
+{
+    int size = static_cast<int>(params.size);
+    lut.assign((size_t)size * size * 2, 0.0f);
+    pool.parallelFor(size, 1, [&](size_t first, size_t last) {
+        for (size_t row = first; row < last; row++)
+            integrateBrdfRow((row + 0.5f) / size, size, params.sampleCount, simd, &lut[row * size * 2]);
+    });
+}
+
+// CPU決ȫ
+struct IblBakeResult {
+    IblCubeMap environment;
+    IrradianceSH irradianceSH;
+    IblCubeMap prefilter;
+};
+
+// תΪ뾫Ȳ.iblcacheĲгϵļͷУwriteIblCache()д룩ʱsaveIblCache()صһһӦͼֻ0
+inline void collectIblCacheImages(const IblBakeResult& result, const IblBakeParams& params, std::vector<std::vector<uint16_t>>& storage,
+                                  std::vector<IblCacheImageData>& images)
+{
+    storage.clear();
+    images.clear();
+    storage.reserve(6 * (1 + params.prefilterMipLevels));
+    auto add = [&](IblCacheTexture texture, uint32_t face, uint32_t level, uint32_t size, uint32_t channels, const float* data) {
+        storage.push_back(std::vector<uint16_t>((size_t)size * size * channels));
+        for (size_t i = 0; i < storage.back().size(); i++)
+            storage.back()[i] = floatToHalf(data[i]);
+        images.push_back(IblCacheImageData{ texture, face, level, size, size, channels, storage.back().data() });
+    };
+    for (uint32_t face = 0; face < 6; face++)
+        add(IBL_ENVIRONMENT, face, 0, params.environmentSize, 3, result.environment.face(0, face));
+    for (uint32_t level = 0; level < params.prefilterMipLevels; level++)
+        for (uint32_t face = 0; face < 6; face++)
+            add(IBL_PREFILTER, face, level, result.prefilter.levelSize(level), 3, result.prefilter.face(level, face));
+}
+#endif
@@ -0,0 +1,231 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <content_hash.h>
+#include <mapped_file.h>
+#include <spherical_harmonics.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// IBLԤĴ̻棨.iblcacheͼԤͼmip԰뾫ȸ㱣棨BRDF LUTHDR޹أʱɲǶ򣬼brdf_lut.h
+// նȵгϵļͷСHDRļݹϣ + 決 + 決ɫԴϣΪ
+// κһ仯º決ǻ档ļGLGPU決Ķغϴibl_upload.h
+// ߹IblBakerCPUͬʽĻ
+const uint32_t IBL_CACHE_VERSION = 3;
+const uint32_t IBL_CACHE_ALIGNMENT = 16;
+
+// 決Ĭֵɫеĳһ
+struct IblBakeParams {
+    uint32_t environmentSize = 512;         // ͼÿߴ
+    uint32_t prefilterSize = 128;           // Ԥͼ0ÿߴ
+    uint32_t prefilterMipLevels = 5;        // Ԥ˵mipֲڶ0~1
+    uint32_t prefilterSampleCount = 1024;   // ԤֲһĲϹ⻬ļ𼶼루ggx_samples.h
+    uint32_t prefilterMinSampleCount = 64;  // Ԥ˴ֲڶȲΪ0ļٲСprefilterSampleCountʱӦ
+    uint32_t shProjectionSize = 64;         // ͶӰնгϵʱȡĻͼmipĳߴ
+};
+
+// б
+enum IblCacheTexture : uint32_t {
+    IBL_ENVIRONMENT = 0,    // ֻ0غglGenerateMipmap
+    IBL_PREFILTER = 1
+};
+
+struct IblCacheHeader {
+    char magic[4];          // "PBRI"
+    uint32_t version;
+    uint64_t sourceHash;    // HDRļݹϣ
+    uint64_t sourceSize;
+    uint64_t bakeKey;       // 決ɫԴĹϣ
+    uint32_t imageCount;
+    uint32_t reserved;
+    IrradianceSH irradianceSH;  // նȵгϵ
+    uint32_t padding[3];        // ʹͼ16ֽڶ
+};
+
+// һһmip
+struct IblCacheImage {
+    uint64_t offset;        // ļͷƫ
+    uint64_t size;          // ֽ
+    uint32_t texture;       // IblCacheTexture
+    uint32_t face;          // ͼ
+    uint32_t level;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;      // 3RGBÿͨһ뾫ȸ
+};
+
+// дʱĳһͼݣ뾫ȸ㣩
+struct IblCacheImageData {
+    uint32_t texture;       // IblCacheTexture
+    uint32_t face;
+    uint32_t level;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    const void* data;
+};
+
+// HDRļӦĻ·
+inline std::string iblCachePath(const std::string& hdrPath)
+{
+    return hdrPath + ".iblcache";
+}
+
+// 決ɫƬɫͼɫ·ߺ決ֵɫ·directoryΪʱΪǰĿ¼
+inline std::vector<std::string> iblBakeShaderPaths(const std::string& directory = std::string())
+{
+    static const char* names[] = { "cubemap.vs", "equirectangular_to_cubemap.fs", "prefilter.fs",
+                                   "equirectangular_to_cubemap.comp", "irradiance_sh.comp", "prefilter.comp" };
+    std::vector<std::string> paths;
+    for (const char* name : names)
+        paths.push_back(directory.empty() ? std::string(name) : directory + '/' + name);
+    return paths;
+}
+
+// 決決ɫԴĹϣɫļȱʧʱݼ
+inline uint64_t iblBakeKey(const IblBakeParams& params, const std::vector<std::string>& shaderPaths)
+{
+    uint64_t key = hashBytes(&params, sizeof(params));
+    for (size_t i = 0; i < shaderPaths.size(); i++)
+    {
+        uint64_t shaderHash = 0;
+        hashFileContents(shaderPaths[i], shaderHash);
+        uint64_t words[2] = { key, shaderHash };
+        key = hashBytes(words, sizeof(words));
+    }
+    return key;
+}
+
+// ######################################
+// # Class IblCacheView
+// ######################################
+// ӳڴеIBLֻͼֻУ鲻
+class IblCacheView
+{
+public:
+    const IblCacheHeader* header;
+    const IblCacheImage* images;
+
+    IblCacheView() : header(nullptr), images(nullptr), base(nullptr)
+    {
+    }
+
+    // Уļͷ͸ͼķΧɹɷheader/images/imageData()
+    bool parse(const unsigned char* data, size_t size)
+    {
+        header = nullptr;
+        images = nullptr;
+        base = data;
+        if (!data || size < sizeof(IblCacheHeader))
+            return false;
+        const IblCacheHeader* candidate = reinterpret_cast<const IblCacheHeader*>(data);
+        if (memcmp(candidate->magic, "PBRI", 4) != 0 || candidate->version != IBL_CACHE_VERSION || candidate->imageCount == 0)
+            return false;
+        if (sizeof(IblCacheHeader) + sizeof(IblCacheImage) * (uint64_t)candidate->imageCount > size)
+            return false;
+        const IblCacheImage* table = reinterpret_cast<const IblCacheImage*>(data + sizeof(IblCacheHeader));
+        for (uint32_t i = 0; i < candidate->imageCount; i++)
+        {
+            const IblCacheImage& image = table[i];
+            if (image.texture > IBL_PREFILTER || image.face >= 6 || image.channels != 3)
+                return false;
+            if (image.offset > size || image.size > size - image.offset
+                || image.size != (uint64_t)image.width * image.height * image.channels * sizeof(uint16_t))
+                return false;
+        }
+        header = candidate;
+        images = table;
+        return true;
+    }
+
+    const unsigned char* imageData(uint32_t image) const
+    {
+        return base + images[image].offset;
+    }
+
+private:
+    const unsigned char* base;
+};
+
+// ӳHDRļӦIBL档治ڡʽЧHDR/決һʱfalse
+// sourceHash/sourceSizeHDRļǰĹϣʹСļʱΪ0δʱд»ʹá
+// GLںִ̨߳
+inline bool openIblCache(const std::string& hdrPath, uint64_t bakeKey, MappedFile& file, IblCacheView& view, uint64_t& sourceHash, uint64_t& sourceSize)
+{
+    sourceHash = 0;
+    sourceSize = 0;
+    if (!hashFileContents(hdrPath, sourceHash, &sourceSize))
+        return false;
+    if (!file.open(iblCachePath(hdrPath)))
+        return false;
+    if (!view.parse(file.data(), file.size()) || view.header->sourceHash != sourceHash || view.header->sourceSize != sourceSize
+        || view.header->bakeKey != bakeKey)
+    {
+        view = IblCacheView();
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+// дļдʱļ滻жʱ²Ļ棩
+inline bool writeIblCache(const std::string& hdrPath, uint64_t sourceHash, uint64_t sourceSize, uint64_t bakeKey, const IrradianceSH& irradianceSH,
+                          const std::vector<IblCacheImageData>& images)
+{
+    std::vector<IblCacheImage> table(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        table[i].texture = images[i].texture;
+        table[i].face = images[i].face;
+        table[i].level = images[i].level;
+        table[i].width = images[i].width;
+        table[i].height = images[i].height;
+        table[i].channels = images[i].channels;
+        table[i].size = (uint64_t)images[i].width * images[i].height * images[i].channels * sizeof(uint16_t);
+    }
+
+    IblCacheHeader header;
+    memcpy(header.magic, "PBRI", 4);
+    header.version = IBL_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.bakeKey = bakeKey;
+    header.imageCount = static_cast<uint32_t>(table.size());
+    header.reserved = 0;
+    header.irradianceSH = irradianceSH;
+    memset(header.padding, 0, sizeof(header.padding));
+    uint64_t offset = sizeof(IblCacheHeader) + sizeof(IblCacheImage) * table.size();
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        offset = (offset + IBL_CACHE_ALIGNMENT - 1) / IBL_CACHE_ALIGNMENT * IBL_CACHE_ALIGNMENT;
+        table[i].offset = offset;
+        offset += table[i].size;
+    }
+
+    std::string path = iblCachePath(hdrPath);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), sizeof(IblCacheImage) * table.size());
+        const char padding[IBL_CACHE_ALIGNMENT] = { 0 };
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(table[i].offset - position));
+            file.write(static_cast<const char*>(images[i].data), static_cast<std::streamsize>(table[i].size));
+        }
+        if (!file.good())
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+#endif
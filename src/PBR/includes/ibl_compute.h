@@ -0,0 +1,124 @@
+#ifndef IBL_COMPUTE_H
+#define IBL_COMPUTE_H
+
+#include <compute_shader.h>
+#include <ibl_cache.h>
+#include <spherical_harmonics.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// IBL決ļɫ·GL 4.3ÿ׶һglDispatchComputeimageStoreֱдĿ
+// Ҫ׽֡桢Ȼÿ/ÿһεĻơնгGPUͶӰùڴԼ
+// ֻÿĲֺ͡Ƭɫ·ͬдͬһIBL档
+// ͼGL_RGBA16F䣨GL_RGB16Fͼʽ
+// ͼ󶨵ģͼglGenerateMipmap
+
+// ######################################
+// # Class IblComputeBaker
+// ######################################
+class IblComputeBaker
+{
+public:
+    // 8x8Ĺ飬.compеlocal_sizeһ
+    static const unsigned int GROUP_SIZE = 8;
+
+    explicit IblComputeBaker(const IblBakeParams& params)
+        : params(params),
+          equirectangularToCubemapShader("equirectangular_to_cubemap.comp"),
+          irradianceSHShader("irradiance_sh.comp"),
+          prefilterShader("prefilter.comp", "#define PREFILTER_MIP_LEVELS " + std::to_string(params.prefilterMipLevels) + "\n")
+    {
+    }
+
+    // ȾHDRͼ󶨵Ԫ0תΪͼ0Ȼmipmap
+    void environment(unsigned int hdrTexture, unsigned int environmentMap)
+    {
+        int size = static_cast<int>(params.environmentSize);
+        equirectangularToCubemapShader.use();
+        equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+        equirectangularToCubemapShader.setInt("size", size);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hdrTexture);
+        glCompute().bindImageTexture(0, environmentMap, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        equirectangularToCubemapShader.dispatch(groups(size), groups(size), 6);
+        // glGenerateMipmap֮ĲҪimageStoreĽ
+        glCompute().memoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environmentMap);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+
+    // ڻͼߴΪshProjectionSizemipmipmapͶӰնгϵ
+    IrradianceSH irradianceSH(unsigned int environmentMap)
+    {
+        int level = 0;
+        while ((params.environmentSize >> (level + 1)) >= params.shProjectionSize)
+            level++;
+        int size = std::max(1, static_cast<int>(params.environmentSize >> level));
+        unsigned int groupCount = groups(size) * groups(size) * 6;
+
+        unsigned int partialBuffer;
+        glGenBuffers(1, &partialBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, partialBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)groupCount * 9 * 4 * sizeof(float), nullptr, GL_STREAM_READ);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, partialBuffer);
+
+        irradianceSHShader.use();
+        irradianceSHShader.setInt("size", size);
+        glCompute().bindImageTexture(0, environmentMap, level, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
+        irradianceSHShader.dispatch(groups(size), groups(size), 6);
+        glCompute().memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        std::vector<float> partials((size_t)groupCount * 9 * 4);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(partials.size() * sizeof(float)), partials.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        glDeleteBuffers(1, &partialBuffer);
+
+        double sums[9][3] = {};
+        for (unsigned int group = 0; group < groupCount; group++)
+            for (int i = 0; i < 9; i++)
+                for (int c = 0; c < 3; c++)
+                    sums[i][c] += partials[((size_t)group * 9 + i) * 4 + c];
+        return irradianceSHFromSums(sums, size);
+    }
+
+    // Ԥͼѷȫmip𣩣мһεɣsampleTableΪprefilterSampleTableϴ
+    void prefilter(unsigned int environmentMap, unsigned int prefilterMap, unsigned int sampleTable, const std::vector<uint32_t>& sampleCounts)
+    {
+        int size = static_cast<int>(params.prefilterSize);
+        prefilterShader.use();
+        prefilterShader.setInt("environmentMap", 0);
+        prefilterShader.setInt("sampleTable", 1);
+        prefilterShader.setInt("size", size);
+        unsigned int groupCount = 0;
+        for (unsigned int level = 0; level < params.prefilterMipLevels; level++)
+        {
+            std::string index = "[" + std::to_string(level) + "]";
+            prefilterShader.setInt("levelGroupOffset" + index, groupCount);
+            prefilterShader.setInt("sampleCount" + index, sampleCounts[level]);
+            unsigned int levelGroups = groups(std::max(1, size >> level));
+            groupCount += levelGroups * levelGroups;
+            glCompute().bindImageTexture(level, prefilterMap, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environmentMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, sampleTable);
+        prefilterShader.dispatch(groupCount, 6);
+        glCompute().memoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    IblBakeParams params;
+    ComputeShader equirectangularToCubemapShader;
+    ComputeShader irradianceSHShader;
+    ComputeShader prefilterShader;
+
+    static unsigned int groups(int size)
+    {
+        return (static_cast<unsigned int>(size) + GROUP_SIZE - 1) / GROUP_SIZE;
+    }
+};
+#endif
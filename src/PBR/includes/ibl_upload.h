@@ -0,0 +1,101 @@
+#ifndef IBL_UPLOAD_H
+#define IBL_UPLOAD_H
+
+#include <glad/glad.h>
+
+#include <ggx_samples.h>
+#include <ibl_cache.h>
+#include <spherical_harmonics.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// IBLCPU֮GL䣺ϴIBLGGXGPU決д뻺桢ͶӰնг
+// ʽGLibl_cache.h
+
+// иIBLGLBRDF LUTڻУbrdf_lut.h
+struct IblTextures {
+    unsigned int environment;
+    unsigned int prefilter;
+};
+
+// IBLеͼϴѷ洢Сenvironmentֻ˵0ϴmipmap
+inline void uploadIblCache(const IblCacheView& view, const IblTextures& textures)
+{
+    const unsigned int ids[2] = { textures.environment, textures.prefilter };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < view.header->imageCount; i++)
+    {
+        const IblCacheImage& image = view.images[i];
+        glBindTexture(GL_TEXTURE_CUBE_MAP, ids[image.texture]);
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + image.face, image.level, 0, 0, image.width, image.height, GL_RGB, GL_HALF_FLOAT,
+                        view.imageData(i));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textures.environment);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+}
+
+// ػͼгߴΪshProjectionSizemipmipmapCPUͶӰΪնгϵ
+inline IrradianceSH readIrradianceSH(unsigned int environment, const IblBakeParams& params)
+{
+    int level = 0;
+    while ((params.environmentSize >> (level + 1)) >= params.shProjectionSize)
+        level++;
+    int size = std::max(1, static_cast<int>(params.environmentSize >> level));
+    std::vector<float> pixels((size_t)6 * size * size * 3);
+    const float* faces[6];
+    glBindTexture(GL_TEXTURE_CUBE_MAP, environment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int face = 0; face < 6; face++)
+    {
+        faces[face] = pixels.data() + (size_t)face * size * size * 3;
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_FLOAT, pixels.data() + (size_t)face * size * size * 3);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    return projectIrradianceSH(faces, size);
+}
+
+// GGXϴΪRGBA32FˣɫtexelFetch(, )ȡ
+inline unsigned int uploadGgxSampleTable(const std::vector<GgxSample>& table, uint32_t width, uint32_t height)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, table.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return textureID;
+}
+
+// ԰뾫ȶGPU決õIBLͬնгϵд뻺
+inline bool saveIblCache(const std::string& hdrPath, uint64_t sourceHash, uint64_t sourceSize, uint64_t bakeKey, const IblBakeParams& params,
+                         const IblTextures& textures, const IrradianceSH& irradianceSH)
+{
+    std::vector<IblCacheImageData> images;
+    std::vector<std::vector<uint16_t>> pixels;
+    pixels.reserve(6 * (1 + params.prefilterMipLevels));
+    auto readBack = [&](IblCacheTexture texture, unsigned int id, uint32_t levels, uint32_t size) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            uint32_t levelSize = std::max(1u, size >> level);
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                pixels.push_back(std::vector<uint16_t>((size_t)levelSize * levelSize * 3));
+                glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_HALF_FLOAT, pixels.back().data());
+                images.push_back(IblCacheImageData{ texture, face, level, levelSize, levelSize, 3, pixels.back().data() });
+            }
+        }
+    };
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    readBack(IBL_ENVIRONMENT, textures.environment, 1, params.environmentSize);
+    readBack(IBL_PREFILTER, textures.prefilter, params.prefilterMipLevels, params.prefilterSize);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    return writeIblCache(hdrPath, sourceHash, sourceSize, bakeKey, irradianceSH, images);
+}
+#endif
@@ -0,0 +1,92 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 8λͼڴstb_image
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int nrComponents = 0;
+    unsigned char* data = nullptr;
+    // νʱ룩ͳ
+    double decodeMs = 0.0;
+};
+
+// ԭشֱתͼ˳
+// stb_imagestbi_set_flip_vertically_on_loadȫ״̬߳̽ʱɵзת
+inline void flipImageVertically(void* data, int width, int height, int bytesPerPixel)
+{
+    size_t rowSize = (size_t)width * bytesPerPixel;
+    std::vector<unsigned char> row(rowSize);
+    unsigned char* pixels = static_cast<unsigned char*>(data);
+    for (int y = 0; y < height / 2; y++)
+    {
+        unsigned char* top = pixels + (size_t)y * rowSize;
+        unsigned char* bottom = pixels + (size_t)(height - 1 - y) * rowSize;
+        memcpy(row.data(), top, rowSize);
+        memcpy(top, bottom, rowSize);
+        memcpy(bottom, row.data(), rowSize);
+    }
+}
+
+// һͼļ̵߳
+inline ImageData decodeImage(const std::string& path, bool flipVertically = false)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    ImageData image;
+    image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.nrComponents, 0);
+    if (image.data && flipVertically)
+        flipImageVertically(image.data, image.width, image.height, image.nrComponents);
+
+    image.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return image;
+}
+
+// ͷͼڴ
+inline void freeImage(ImageData& image)
+{
+    if (image.data)
+        stbi_image_free(image.data);
+    image.data = nullptr;
+}
+
+// 8λͼдΪδѹTGAԭϽǣstb_imageֱӶȡֿûͼ⣬߹мͼ
+inline bool writeImageTGA(const std::string& path, const unsigned char* pixels, int width, int height, int nrComponents)
+{
+    if (nrComponents != 1 && nrComponents != 3 && nrComponents != 4)
+        return false;
+    unsigned char header[18] = {};
+    header[2] = nrComponents == 1 ? 3 : 2;
+    header[12] = static_cast<unsigned char>(width & 0xFF);
+    header[13] = static_cast<unsigned char>(width >> 8);
+    header[14] = static_cast<unsigned char>(height & 0xFF);
+    header[15] = static_cast<unsigned char>(height >> 8);
+    header[16] = static_cast<unsigned char>(nrComponents * 8);
+    header[17] = 0x20 | (nrComponents == 4 ? 8 : 0);
+
+    // TGABGR(A)˳洢
+    std::vector<unsigned char> row((size_t)width * nrComponents);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int y = 0; y < height; y++)
+    {
+        memcpy(row.data(), pixels + (size_t)y * row.size(), row.size());
+        if (nrComponents >= 3)
+            for (size_t x = 0; x < row.size(); x += nrComponents)
+                std::swap(row[x], row[x + 2]);
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    return file.good();
+}
+#endif
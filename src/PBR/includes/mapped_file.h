@@ -0,0 +1,146 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+// ######################################
+// # Class MappedFile
+// ######################################
+// ֻڴӳļֱԲϵͳҳ棬Ŀ
+class MappedFile
+{
+public:
+    MappedFile() : mappedData(nullptr), mappedSize(0)
+    {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        fd = -1;
+#endif
+    }
+
+    explicit MappedFile(const std::string& path) : MappedFile()
+    {
+        open(path);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    // ӳļʧܣļʱfalse
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            close();
+            return false;
+        }
+        mappedData = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+        void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            mappedData = static_cast<const unsigned char*>(address);
+            mappedSize = static_cast<size_t>(st.st_size);
+        }
+#endif
+        if (!mappedData)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // ӳ䲢رļ
+    void close()
+    {
+#ifdef _WIN32
+        if (mappedData)
+            UnmapViewOfFile(mappedData);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (mappedData)
+            munmap(const_cast<unsigned char*>(mappedData), mappedSize);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#endif
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+
+    bool isOpen() const
+    {
+        return mappedData != nullptr;
+    }
+
+    const unsigned char* data() const
+    {
+        return mappedData;
+    }
+
+    size_t size() const
+    {
+        return mappedSize;
+    }
+
+private:
+    const unsigned char* mappedData;
+    size_t mappedSize;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
+#endif
@@ -0,0 +1,98 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <gl_state_cache.h>
+#include <shader.h>
+
+// һPBRʵͼormΪ0ʱʹôORMͼR: ao, G: roughness, B: metallicʱmetallic/roughness/aoΪ0
+// targetΪGL_TEXTURE_2D_ARRAYʱͼΪͼ飨material_atlas.h
+struct PbrMaterialMaps {
+    unsigned int albedo = 0;
+    unsigned int normal = 0;
+    unsigned int metallic = 0;
+    unsigned int roughness = 0;
+    unsigned int ao = 0;
+    unsigned int orm = 0;
+    GLenum target = GL_TEXTURE_2D;
+};
+
+// һPBRͼORMͼʱֻ3Ԫ5Ѱ󶨵ͼظ
+inline void bindPbrMaterial(const PbrMaterialMaps& maps)
+{
+    GLStateCache& state = GLStateCache::instance();
+    state.bindTexture(3, maps.target, maps.albedo);
+    state.bindTexture(4, maps.target, maps.normal);
+    if (maps.orm)
+    {
+        state.bindTexture(5, maps.target, maps.orm);
+        return;
+    }
+    state.bindTexture(5, maps.target, maps.metallic);
+    state.bindTexture(6, maps.target, maps.roughness);
+    state.bindTexture(7, maps.target, maps.ao);
+}
+
+// ʵıɫͼĲֵalbedoԿռ䣩albedoTintmetallicroughnessԸԵźȡ[0, 1]
+// ao1ͼֵ֮䰴aoStrengthֵĬֵıͼĽpbr.fsuniformĳֵͬ
+struct PbrMaterialFactors {
+    glm::vec3 albedoTint = glm::vec3(1.0f);
+    float metallicScale = 1.0f;
+    float roughnessScale = 1.0f;
+    float aoStrength = 1.0f;
+
+    bool operator==(const PbrMaterialFactors& other) const
+    {
+        return albedoTint == other.albedoTint && metallicScale == other.metallicScale && roughnessScale == other.roughnessScale
+            && aoStrength == other.aoStrength;
+    }
+};
+
+// pbr.fsвʲuniformľÿһ
+struct PbrMaterialUniforms {
+    UniformHandle<glm::vec3> albedoTint;
+    UniformHandle<float> metallicScale;
+    UniformHandle<float> roughnessScale;
+    UniformHandle<float> aoStrength;
+
+    PbrMaterialUniforms()
+    {
+    }
+
+    explicit PbrMaterialUniforms(Shader& shader)
+        : albedoTint(shader.uniform<glm::vec3>("albedoTint")), metallicScale(shader.uniform<float>("metallicScale")),
+          roughnessScale(shader.uniform<float>("roughnessScale")), aoStrength(shader.uniform<float>("aoStrength"))
+    {
+    }
+};
+
+// ϴһʵıshaderΪǰ򡣳uniformֵڲ֮䱣лʱҪϴ
+inline void setPbrMaterialFactors(const Shader& shader, const PbrMaterialUniforms& uniforms, const PbrMaterialFactors& factors)
+{
+    shader.set(uniforms.albedoTint, factors.albedoTint);
+    shader.set(uniforms.metallicScale, factors.metallicScale);
+    shader.set(uniforms.roughnessScale, factors.roughnessScale);
+    shader.set(uniforms.aoStrength, factors.aoStrength);
+}
+
+// ######################################
+// # Struct Material
+// ######################################
+// ʣͼͻõɫshaderͼƥ䣨ORMͼʱΪUSE_ORM_MAP壬ʱΪUSE_MATERIAL_ARRAY壩
+// ڲʹڼ䱣Ч
+struct Material {
+    PbrMaterialMaps maps;
+    PbrMaterialFactors factors;
+    Shader* shader = nullptr;
+
+    // ɫͼϴÿζֲuniformʵĻSceneRegistry򻺴
+    void bind() const
+    {
+        shader->use();
+        bindPbrMaterial(maps);
+        setPbrMaterialFactors(*shader, PbrMaterialUniforms(*shader), factors);
+    }
+};
+#endif
@@ -0,0 +1,244 @@
+#ifndef MATERIAL_ATLAS_H
+#define MATERIAL_ATLAS_H
+
+#include <glad/glad.h>
+
+#include <gl_extensions.h>
+#include <material.h>
+#include <shader.h>
+
+#include <vector>
+
+// GL 4.3/ARB_copy_imageֱ֮Ӹͼݣ֡壬ҲҪѹѹʽ
+// gladֻ3.3ĵļҪԼ
+struct GLCopyImageFunctions {
+    void (APIENTRYP copyImageSubData)(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+                                      GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ,
+                                      GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth) = nullptr;
+    bool supported = false;
+};
+
+inline GLCopyImageFunctions& glCopyImage()
+{
+    static GLCopyImageFunctions functions;
+    return functions;
+}
+
+// glCopyImageSubData֧ʱfalseʱͼʷֱ
+inline bool loadGLCopyImage(GLADloadproc load)
+{
+    GLCopyImageFunctions& functions = glCopyImage();
+    if (hasGLVersion(4, 3) || hasGLExtension("GL_ARB_copy_image"))
+        functions.copyImageSubData = reinterpret_cast<void (APIENTRYP)(GLuint, GLenum, GLint, GLint, GLint, GLint, GLuint, GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei)>(load("glCopyImageSubData"));
+    functions.supported = functions.copyImageSubData != nullptr;
+    return functions.supported;
+}
+
+// ʵͼۣalbedonormalmetallicroughnessaoorm
+const int MATERIAL_MAP_SLOTS = 6;
+
+inline unsigned int& materialMapSlot(PbrMaterialMaps& maps, int slot)
+{
+    unsigned int* slots[MATERIAL_MAP_SLOTS] = { &maps.albedo, &maps.normal, &maps.metallic, &maps.roughness, &maps.ao, &maps.orm };
+    return *slots[slot];
+}
+
+inline unsigned int materialMapSlot(const PbrMaterialMaps& maps, int slot)
+{
+    return materialMapSlot(const_cast<PbrMaterialMaps&>(maps), slot);
+}
+
+// һ2Dĳߴ硢ڲʽѶmipߴ͸ʽܷͬŽͬһ
+struct MaterialMapFormat {
+    GLint width = 0;
+    GLint height = 0;
+    GLint internalFormat = 0;
+    GLint levels = 0;
+
+    bool operator==(const MaterialMapFormat& other) const
+    {
+        return width == other.width && height == other.height && internalFormat == other.internalFormat && levels == other.levels;
+    }
+};
+
+// ѯĸʽtextureΪ0ûд洢ʱȫ0ֱӰ󶨵ǰԪֻ֮֡ãGLStateCachebeginFrame()ʱ¼
+inline MaterialMapFormat queryMaterialMapFormat(unsigned int texture)
+{
+    MaterialMapFormat format;
+    if (texture == 0)
+        return format;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &format.width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &format.height);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format.internalFormat);
+    // ûд洢ʱڲʽԷĬֵδô
+    if (format.width == 0)
+        return MaterialMapFormat();
+    // ӵ0ʼļ1x1һδļΪֹ
+    GLint width = format.width, height = format.height;
+    while (width > 0)
+    {
+        format.levels++;
+        if (width == 1 && height == 1)
+            break;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, format.levels, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, format.levels, GL_TEXTURE_HEIGHT, &height);
+    }
+    return format;
+}
+
+// ######################################
+// # Class MaterialAtlas
+// ######################################
+// ͼѼʵͬһͼƵһGL_TEXTURE_2D_ARRAYĸУiλڵi㡣
+// ЩʺϳһMaterialɫUSE_MATERIAL_ARRAY尴ĲŲ
+// ֻвʲͬϲ󣨼MeshBatchһλɡ
+// GPUϽУglCopyImageSubDataBCѹͼֱӸѹ顣ͼѼɣʽصͼȫϴܹ֮
+class MaterialAtlas
+{
+public:
+    MaterialAtlas()
+    {
+        for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+            arrays[slot] = 0;
+    }
+
+    // ܷŽͬһͼɫͱͬͼֻһײÿͼ۵ĳߴ硢ʽmipͬ
+    // ûд洢ͼʧܣΪ0δõͼͬͼиòҲ
+    static bool compatible(const Material& a, const Material& b)
+    {
+        if (a.shader != b.shader || !(a.factors == b.factors) || a.maps.target != GL_TEXTURE_2D || b.maps.target != GL_TEXTURE_2D)
+            return false;
+        for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+            if (!(queryMaterialMapFormat(materialMapSlot(a.maps, slot)) == queryMaterialMapFormat(materialMapSlot(b.maps, slot))))
+                return false;
+        return true;
+    }
+
+    // ѲʰԷ飬ظĲ±ꡣֻһʵûкϲ壬
+    static std::vector<std::vector<size_t>> group(const std::vector<Material>& materials)
+    {
+        std::vector<std::vector<size_t>> groups;
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            bool added = false;
+            for (std::vector<size_t>& group : groups)
+            {
+                if (compatible(materials[group[0]], materials[i]))
+                {
+                    group.push_back(i);
+                    added = true;
+                    break;
+                }
+            }
+            if (!added)
+                groups.push_back(std::vector<size_t>(1, i));
+        }
+        std::vector<std::vector<size_t>> result;
+        for (std::vector<size_t>& group : groups)
+            if (group.size() > 1)
+                result.push_back(group);
+        return result;
+    }
+
+    // materialsͼarrayShaderΪЩʶӦUSE_MATERIAL_ARRAYɫ塣
+    // ֧glCopyImageSubDataʲݻ򳬹ʱfalseκ
+    bool build(const std::vector<Material>& materials, Shader* arrayShader)
+    {
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        // ΪGL_UNSIGNED_BYTEԴ룬256
+        if (!glCopyImage().supported || materials.empty() || materials.size() > 256 || static_cast<GLint>(materials.size()) > maxLayers)
+            return false;
+        for (size_t i = 1; i < materials.size(); i++)
+            if (!compatible(materials[0], materials[i]))
+                return false;
+
+        release();
+        GLsizei layers = static_cast<GLsizei>(materials.size());
+        for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+        {
+            unsigned int first = materialMapSlot(materials[0].maps, slot);
+            MaterialMapFormat format = queryMaterialMapFormat(first);
+            if (format.levels == 0)
+                continue;
+            glBindTexture(GL_TEXTURE_2D, first);
+            GLint compressed = GL_FALSE;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+            std::vector<GLint> levelBytes(format.levels, 0);
+            if (compressed)
+                for (GLint level = 0; level < format.levels; level++)
+                    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelBytes[level]);
+
+            // Ĵ洢ǰҪмѶ壬MAX_LEVEL֮ƥ䣩
+            glGenTextures(1, &arrays[slot]);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[slot]);
+            GLsizei width = format.width, height = format.height;
+            for (GLint level = 0; level < format.levels; level++)
+            {
+                if (compressed)
+                    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat, width, height, layers, 0, levelBytes[level] * layers, nullptr);
+                else
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                width = width > 1 ? width / 2 : 1;
+                height = height > 1 ? height / 2 : 1;
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, format.levels - 1);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            for (GLsizei layer = 0; layer < layers; layer++)
+            {
+                unsigned int source = materialMapSlot(materials[layer].maps, slot);
+                width = format.width;
+                height = format.height;
+                for (GLint level = 0; level < format.levels; level++)
+                {
+                    glCopyImage().copyImageSubData(source, GL_TEXTURE_2D, level, 0, 0, 0,
+                                                   arrays[slot], GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+                    width = width > 1 ? width / 2 : 1;
+                    height = height > 1 ? height / 2 : 1;
+                }
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        atlas.maps.target = GL_TEXTURE_2D_ARRAY;
+        for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+            materialMapSlot(atlas.maps, slot) = arrays[slot];
+        atlas.factors = materials[0].factors;
+        atlas.shader = arrayShader;
+        return true;
+    }
+
+    // ɾͼ
+    void release()
+    {
+        for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+        {
+            if (arrays[slot])
+                glDeleteTextures(1, &arrays[slot]);
+            arrays[slot] = 0;
+        }
+        atlas = Material();
+    }
+
+    // ͼӦĲʣͼΪ飬ɫΪbuild()ʱı
+    const Material& material() const
+    {
+        return atlas;
+    }
+
+    bool built() const
+    {
+        return atlas.shader != nullptr;
+    }
+
+private:
+    unsigned int arrays[MATERIAL_MAP_SLOTS];
+    Material atlas;
+};
+#endif
@@ -47,29 +47,117 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    unsigned int indexCount;
 
-    // 캯
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // 캯deferSetupΪtrueʱGLڹ߳й죩֮GL̵߳setupMesh()
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool deferSetup = false)
+        : VAO(0), externalVertices(nullptr), externalIndices(nullptr), externalVertexCount(0)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->indexCount = static_cast<unsigned int>(indices.size());
 
         // ö㻺ָ
-        setupMesh();
+        if (!deferSetup)
+            setupMesh();
+    }
+
+    // ⲿڴ棨ӳ񻺴棩ֱϴCPU˱
+    // ӳϴʱⲿڴ豣ЧֱsetupMesh()
+    Mesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount, vector<Texture> textures, bool deferSetup = false)
+        : VAO(0), externalVertices(vertexData), externalIndices(indexData), externalVertexCount(vertexCount)
+    {
+        this->textures = textures;
+        this->indexCount = static_cast<unsigned int>(indexCount);
+
+        if (!deferSetup)
+            setupMesh();
+    }
+
+    // 㻺岢ϴݣֻGL̵߳ãϴʱκ
+    void setupMesh()
+    {
+        if (VAO != 0)
+            return;
+        if (externalVertices)
+            setupBuffers(externalVertices, externalVertexCount, externalIndices, indexCount);
+        else
+            setupBuffers(vertices.data(), vertices.size(), indices.data(), indices.size());
+        externalVertices = nullptr;
+        externalIndices = nullptr;
     }
 
     // Ⱦ
     void Draw(Shader &shader) 
     {
+        // texture_diffuse1ֻڵһλʱ
+        if (samplerNames.size() != textures.size())
+            buildSamplerNames();
         // ص
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // ԪĲ
+            shader.setInt(samplerNames[i], i);
+            // 
+            GLStateCache::instance().bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        // 
+        GLStateCache::instance().bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+
+    // ϴĶ㻺壨MeshBatchϲʱGPUϸƣ
+    unsigned int vertexBuffer() const
+    {
+        return VBO;
+    }
+
+    unsigned int indexBuffer() const
+    {
+        return EBO;
+    }
+
+    // Ϊǰ󶨵VAOVertexָ루λ06ȡԵǰ󶨵GL_ARRAY_BUFFER
+    static void setupVertexAttributes()
+    {
+        glEnableVertexAttribArray(0);	
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(1);	
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);	
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+		glEnableVertexAttribArray(5);
+		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+		glEnableVertexAttribArray(6);
+		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+    }
+
+private:
+    // 㻺Ԫػ
+    unsigned int VBO, EBO;
+    // ӳϴⲿ/
+    const Vertex* externalVertices;
+    const unsigned int* externalIndices;
+    size_t externalVertexCount;
+    // ӦĲuniform
+    vector<string> samplerNames;
+
+    // Ϊţtexture_diffuse1texture_diffuse2texture_normal1
+    void buildSamplerNames()
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        samplerNames.clear();
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); 
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
@@ -80,56 +168,27 @@ public:
                 number = std::to_string(normalNr++);
              else if(name == "texture_height")
                 number = std::to_string(heightNr++);
-
-            // ԪĲ
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // 
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            samplerNames.push_back(name + number);
         }
-        
-        // 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // ָĬ
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // 㻺Ԫػ
-    unsigned int VBO, EBO;
-
     // ʼеĻ/
-    void setupMesh()
+    void setupBuffers(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount)
     {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLStateCache::instance().bindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);  
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
 
         // ʼеĻ/
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        setupVertexAttributes();
+        GLStateCache::instance().bindVertexArray(0);
     }
 };
 #endif
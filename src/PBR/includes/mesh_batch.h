@@ -0,0 +1,119 @@
+#ifndef MESH_BATCH_H
+#define MESH_BATCH_H
+
+#include <glad/glad.h>
+
+#include <gl_state_cache.h>
+#include <mesh.h>
+#include <model.h>
+
+#include <algorithm>
+#include <vector>
+
+// ϲвʲŵĶλãɫΪpbr.vsaMaterialLayerUSE_MATERIAL_ARRAY壩
+const GLuint MATERIAL_LAYER_ATTRIBUTE = 7;
+
+// ######################################
+// # Class MeshBatch
+// ######################################
+// Ѽʹͬһ任ģͺϲһVAO㻺GPUθƣglCopyBufferSubData
+// غϸĶƫдһ壬һĲŻ壨GL_UNSIGNED_BYTE
+// ÿģ͵ĲŶӦMaterialAtlasĲڵĲ㣬ϲһglDrawElementsȫģ
+class MeshBatch
+{
+public:
+    unsigned int VAO;
+    unsigned int indexCount;
+
+    MeshBatch()
+        : VAO(0), indexCount(0), VBO(0), EBO(0), layerBuffer(0)
+    {
+    }
+
+    // һϴuploadMeshes()֮󣩵ģͣlayerΪͼеĲ㣨0255
+    void add(const Model& model, unsigned int layer)
+    {
+        for (const Mesh& mesh : model.meshes)
+            parts.push_back(Part{ &mesh, static_cast<unsigned char>(layer) });
+    }
+
+    // ϲĻVAOֻGL̵߳áģڵڼЧ֮
+    void build()
+    {
+        // Ķɶ㻺ĴСõӳ񻺴ϴCPUûж㸱
+        std::vector<GLint64> vertexBytes(parts.size(), 0);
+        GLint64 totalVertexBytes = 0;
+        GLsizeiptr totalIndices = 0;
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, parts[i].mesh->vertexBuffer());
+            glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes[i]);
+            totalVertexBytes += vertexBytes[i];
+            totalIndices += parts[i].mesh->indexCount;
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &layerBuffer);
+
+        // 㣺GPUθƣţÿһֽ
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(totalVertexBytes), nullptr, GL_STATIC_DRAW);
+        std::vector<unsigned char> layers(static_cast<size_t>(totalVertexBytes / sizeof(Vertex)));
+        GLint64 vertexOffset = 0;
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, parts[i].mesh->vertexBuffer());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, static_cast<GLintptr>(vertexOffset), static_cast<GLsizeiptr>(vertexBytes[i]));
+            std::fill(layers.begin() + static_cast<size_t>(vertexOffset / sizeof(Vertex)),
+                      layers.begin() + static_cast<size_t>((vertexOffset + vertexBytes[i]) / sizeof(Vertex)), parts[i].layer);
+            vertexOffset += vertexBytes[i];
+        }
+
+        // غ׶
+        std::vector<unsigned int> indices(static_cast<size_t>(totalIndices));
+        size_t indexOffset = 0;
+        unsigned int firstVertex = 0;
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            const Mesh& mesh = *parts[i].mesh;
+            glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer());
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, mesh.indexCount * sizeof(unsigned int), indices.data() + indexOffset);
+            for (size_t j = indexOffset; j < indexOffset + mesh.indexCount; j++)
+                indices[j] += firstVertex;
+            indexOffset += mesh.indexCount;
+            firstVertex += static_cast<unsigned int>(vertexBytes[i] / sizeof(Vertex));
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        indexCount = static_cast<unsigned int>(totalIndices);
+
+        GLStateCache::instance().bindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        Mesh::setupVertexAttributes();
+        glBindBuffer(GL_ARRAY_BUFFER, layerBuffer);
+        glBufferData(GL_ARRAY_BUFFER, layers.size(), layers.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(MATERIAL_LAYER_ATTRIBUTE);
+        glVertexAttribPointer(MATERIAL_LAYER_ATTRIBUTE, 1, GL_UNSIGNED_BYTE, GL_FALSE, 1, (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        GLStateCache::instance().bindVertexArray(0);
+        parts.clear();
+    }
+
+    bool built() const
+    {
+        return VAO != 0;
+    }
+
+private:
+    struct Part {
+        const Mesh* mesh;
+        unsigned char layer;
+    };
+
+    unsigned int VBO, EBO, layerBuffer;
+    std::vector<Part> parts;
+};
+#endif
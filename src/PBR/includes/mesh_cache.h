@@ -0,0 +1,218 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <content_hash.h>
+#include <mapped_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ģ񻺴棨.mcacheļͷ +  +  + 16ֽڶĶ/ݡ
+// Դļݹϣݵĵ͵־ΪʱֱӳļϴVBO/EBO
+const uint32_t MESH_CACHE_VERSION = 2;
+const uint32_t MESH_CACHE_ALIGNMENT = 16;
+
+// ɻݵĵͬͬһļߡ˳ȣȫͬ治ܻ
+const uint32_t MESH_IMPORTER_ASSIMP = 1;
+const uint32_t MESH_IMPORTER_OBJ = 2;     // õ.objȡobj_loader.h
+
+struct MeshCacheHeader {
+    char magic[4];          // "PBRM"
+    uint32_t version;
+    uint32_t importFlags;   // ɻʱASSIMPʹõĺ־
+    uint32_t vertexStride;  // sizeof(Vertex)ṹ仯󻺴ԶʧЧ
+    uint32_t importer;      // MESH_IMPORTER_*
+    uint32_t reserved;
+    uint64_t sourceHash;    // Դļݹϣ
+    uint64_t sourceSize;
+    uint32_t meshCount;
+    uint32_t textureCount;
+};
+
+struct MeshCacheMesh {
+    uint64_t vertexOffset;  // ļͷƫ
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;  // еʼλ
+    uint32_t textureCount;
+};
+
+// õĲ·ģĿ¼
+struct MeshCacheTexture {
+    char type[32];
+    char path[256];
+};
+
+// дʱĳһ
+struct MeshCacheData {
+    const void* vertices;
+    uint32_t vertexCount;
+    const unsigned int* indices;
+    uint32_t indexCount;
+    std::vector<MeshCacheTexture> textures;
+};
+
+// ģļӦĻ·
+inline std::string meshCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".mcache";
+}
+
+// ַʱfalseд棩
+inline bool makeMeshCacheTexture(const std::string& type, const std::string& path, MeshCacheTexture& texture)
+{
+    if (type.size() >= sizeof(texture.type) || path.size() >= sizeof(texture.path))
+        return false;
+    memset(&texture, 0, sizeof(texture));
+    memcpy(texture.type, type.c_str(), type.size());
+    memcpy(texture.path, path.c_str(), path.size());
+    return true;
+}
+
+// д񻺴棬headerеmagic/version/meshCount/textureCountɱд
+inline bool writeMeshCache(const std::string& path, MeshCacheHeader header, const std::vector<MeshCacheData>& meshes)
+{
+    memcpy(header.magic, "PBRM", 4);
+    header.version = MESH_CACHE_VERSION;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.textureCount = 0;
+
+    std::vector<MeshCacheMesh> table(meshes.size());
+    std::vector<MeshCacheTexture> textures;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        table[i].firstTexture = static_cast<uint32_t>(textures.size());
+        table[i].textureCount = static_cast<uint32_t>(meshes[i].textures.size());
+        textures.insert(textures.end(), meshes[i].textures.begin(), meshes[i].textures.end());
+    }
+    header.textureCount = static_cast<uint32_t>(textures.size());
+
+    auto align = [](uint64_t offset) { return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT; };
+    uint64_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheMesh) * table.size() + sizeof(MeshCacheTexture) * textures.size();
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        table[i].vertexCount = meshes[i].vertexCount;
+        table[i].indexCount = meshes[i].indexCount;
+        table[i].vertexOffset = offset = align(offset);
+        offset += (uint64_t)meshes[i].vertexCount * header.vertexStride;
+        table[i].indexOffset = offset = align(offset);
+        offset += (uint64_t)meshes[i].indexCount * sizeof(unsigned int);
+    }
+
+    // дʱļ滻жʱ²Ļ
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), sizeof(MeshCacheMesh) * table.size());
+        file.write(reinterpret_cast<const char*>(textures.data()), sizeof(MeshCacheTexture) * textures.size());
+        const char padding[MESH_CACHE_ALIGNMENT] = { 0 };
+        auto writeAt = [&](uint64_t target, const void* data, uint64_t size) {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(target - position));
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            writeAt(table[i].vertexOffset, meshes[i].vertices, (uint64_t)meshes[i].vertexCount * header.vertexStride);
+            writeAt(table[i].indexOffset, meshes[i].indices, (uint64_t)meshes[i].indexCount * sizeof(unsigned int));
+        }
+        if (!file.good())
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+// ######################################
+// # Class MeshCacheView
+// ######################################
+// ӳڴе񻺴ֻͼֻУ鲻
+class MeshCacheView
+{
+public:
+    const MeshCacheHeader* header;
+    const MeshCacheMesh* meshes;
+    const MeshCacheTexture* textures;
+
+    MeshCacheView() : header(nullptr), meshes(nullptr), textures(nullptr), base(nullptr)
+    {
+    }
+
+    // Уļͷ͸εķΧɹɷheader/meshes/textures㡢
+    bool parse(const unsigned char* data, size_t size)
+    {
+        header = nullptr;
+        meshes = nullptr;
+        textures = nullptr;
+        base = data;
+        if (!data || size < sizeof(MeshCacheHeader))
+            return false;
+        const MeshCacheHeader* candidate = reinterpret_cast<const MeshCacheHeader*>(data);
+        if (memcmp(candidate->magic, "PBRM", 4) != 0 || candidate->version != MESH_CACHE_VERSION)
+            return false;
+        uint64_t tableSize = sizeof(MeshCacheHeader) + sizeof(MeshCacheMesh) * (uint64_t)candidate->meshCount
+                           + sizeof(MeshCacheTexture) * (uint64_t)candidate->textureCount;
+        if (tableSize > size)
+            return false;
+        const MeshCacheMesh* meshTable = reinterpret_cast<const MeshCacheMesh*>(data + sizeof(MeshCacheHeader));
+        for (uint32_t i = 0; i < candidate->meshCount; i++)
+        {
+            const MeshCacheMesh& mesh = meshTable[i];
+            uint64_t vertexBytes = (uint64_t)mesh.vertexCount * candidate->vertexStride;
+            uint64_t indexBytes = (uint64_t)mesh.indexCount * sizeof(unsigned int);
+            if (mesh.vertexOffset > size || vertexBytes > size - mesh.vertexOffset)
+                return false;
+            if (mesh.indexOffset > size || indexBytes > size - mesh.indexOffset)
+                return false;
+            if ((uint64_t)mesh.firstTexture + mesh.textureCount > candidate->textureCount)
+                return false;
+        }
+        header = candidate;
+        meshes = meshTable;
+        textures = reinterpret_cast<const MeshCacheTexture*>(meshTable + candidate->meshCount);
+        return true;
+    }
+
+    const void* vertexData(uint32_t mesh) const
+    {
+        return base + meshes[mesh].vertexOffset;
+    }
+
+    const unsigned int* indexData(uint32_t mesh) const
+    {
+        return reinterpret_cast<const unsigned int*>(base + meshes[mesh].indexOffset);
+    }
+
+private:
+    const unsigned char* base;
+};
+
+// ӳԴļӦ񻺴档治ڡʽЧԴļ//־/㲼ֲһʱfalse
+// sourceHash/sourceSizeԴļǰĹϣʹСδʱд»ʹ
+inline bool openMeshCache(const std::string& sourcePath, uint32_t importer, uint32_t importFlags, uint32_t vertexStride, MappedFile& file, MeshCacheView& view,
+                          uint64_t& sourceHash, uint64_t& sourceSize)
+{
+    sourceHash = 0;
+    sourceSize = 0;
+    if (!hashFileContents(sourcePath, sourceHash, &sourceSize))
+        return false;
+    if (!file.open(meshCachePath(sourcePath)))
+        return false;
+    if (!view.parse(file.data(), file.size()) || view.header->sourceHash != sourceHash || view.header->sourceSize != sourceSize
+        || view.header->importer != importer || view.header->importFlags != importFlags || view.header->vertexStride != vertexStride)
+    {
+        view = MeshCacheView();
+        file.close();
+        return false;
+    }
+    return true;
+}
+#endif
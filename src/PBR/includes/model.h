@@ -11,18 +11,27 @@
 #include <assimp/postprocess.h>
 
 #include <mesh.h>
+#include <mesh_cache.h>
+#include <obj_loader.h>
 #include <shader.h>
+#include <texture_cache.h>
+#include <texture_streamer.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// ASSIMP־ͬʱΪ񻺴ļ֮һ޸ĺɻԶʧЧ
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
 // ######################################
 // # Class Model
 // ######################################
@@ -31,14 +40,38 @@ class Model
 public:
     // ģ
     vector<Texture> textures_loaded;	// ѼصбŻȷμ
+    unordered_map<string, size_t> textures_index;   // е· -> textures_loadedе±
     vector<Mesh>    meshes;             // б
     string directory;                   // ģļĿ¼
     bool gammaCorrection;               // ٤У־
+    TextureStreamer* streamer;          // Ϊʱ첽ʽ
+    ThreadPool* meshPool;               // Ϊʱ.objļڸ̳߳вн
 
-    // 캯һ3Dģ͵ļ·
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // 캯һ3Dģ͵ļ·
+    // deferUploadΪtrueʱֻCPU˵ĵ루ڹ߳й죩Ͷ㻺֮uploadMeshes()ʱ
+    Model(string const &path, bool gamma = false, TextureStreamer* streamer = nullptr, ThreadPool* meshPool = nullptr, bool deferUpload = false)
+        : gammaCorrection(gamma), streamer(streamer), meshPool(meshPool)
     {
         loadModel(path);
+        if (!deferUpload)
+            uploadMeshes();
+    }
+
+    // GL߳мõ㻺
+    void uploadMeshes()
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            for (unsigned int j = 0; j < meshes[i].textures.size(); j++)
+            {
+                Texture& texture = meshes[i].textures[j];
+                if (texture.id == 0)
+                    texture.id = loadTexture(texture.path.c_str(), texture.type).id;
+            }
+            meshes[i].setupMesh();
+        }
+        // ϴҪӳ񻺴
+        meshCacheFile.reset();
     }
 
     // ģͣӶе
@@ -49,23 +82,139 @@ public:
     }
     
 private:
+    // ӳϴʱ񻺴ӳ䣬ֱеĶ
+    shared_ptr<MappedFile> meshCacheFile;
+
     // ļشASSIMPֵ֧չģͣɵ洢meshes
+    // Դļݡ͵־һµ񻺴棬ֱӴӻ
     void loadModel(string const &path)
     {
+        // ȡļ·Ŀ¼·
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // .objʹõĶȡֻɵĻ
+        bool isObj = fileExtension(path) == "obj";
+        meshCacheFile = make_shared<MappedFile>();
+        MeshCacheView cache;
+        uint64_t sourceHash, sourceSize;
+        if (openMeshCache(path, isObj ? MESH_IMPORTER_OBJ : MESH_IMPORTER_ASSIMP, MODEL_IMPORT_FLAGS, sizeof(Vertex), *meshCacheFile, cache, sourceHash, sourceSize))
+        {
+            loadFromCache(cache);
+            return;
+        }
+        meshCacheFile.reset();
+
+        // .objʹõĲжȡʧʱٽASSIMP
+        if (isObj)
+        {
+            ObjModel obj;
+            string error;
+            if (loadObj(path, obj, meshPool, error))
+            {
+                processObj(obj);
+                if (sourceSize > 0)
+                    writeCache(path, MESH_IMPORTER_OBJ, sourceHash, sourceSize);
+                return;
+            }
+            cout << "ERROR::OBJ:: " << error << ", falling back to ASSIMP" << endl;
+        }
+
         // ͨASSIMPȡļ
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
         // 
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // ȡļ·Ŀ¼·
-        directory = path.substr(0, path.find_last_of('/'));
 
         // ݹ鴦ASSIMPĸڵ
         processNode(scene->mRootNode, scene);
+
+        // .obj˻ASSIMPʱд棺´μ԰öȡĻңASSIMPɵĻ治
+        if (sourceSize > 0 && !isObj)
+            writeCache(path, MESH_IMPORTER_ASSIMP, sourceHash, sourceSize);
+    }
+
+    // ӳ񻺴洴񣬶uploadMeshes()ֱӴӳڴϴVBO/EBO
+    void loadFromCache(const MeshCacheView& cache)
+    {
+        for (uint32_t i = 0; i < cache.header->meshCount; i++)
+        {
+            const MeshCacheMesh& entry = cache.meshes[i];
+            vector<Texture> textures;
+            for (uint32_t j = 0; j < entry.textureCount; j++)
+            {
+                const MeshCacheTexture& texture = cache.textures[entry.firstTexture + j];
+                textures.push_back(textureReference(texture.path, texture.type));
+            }
+            meshes.push_back(Mesh(static_cast<const Vertex*>(cache.vertexData(i)), entry.vertexCount, cache.indexData(i), entry.indexCount, textures, true));
+        }
+    }
+
+    // OBJȡĽתΪ˳processMeshͬ
+    void processObj(const ObjModel& obj)
+    {
+        for (size_t i = 0; i < obj.meshes.size(); i++)
+        {
+            const ObjMesh& source = obj.meshes[i];
+            vector<Vertex> vertices(source.vertices.size());
+            for (size_t j = 0; j < source.vertices.size(); j++)
+            {
+                const ObjVertex& v = source.vertices[j];
+                Vertex vertex = Vertex();
+                vertex.Position = v.position;
+                vertex.Normal = v.normal;
+                vertex.TexCoords = v.texCoords;
+                vertex.Tangent = v.tangent;
+                vertex.Bitangent = v.bitangent;
+                vertices[j] = vertex;
+            }
+            vector<Texture> textures;
+            if (source.material >= 0)
+            {
+                const ObjMaterial& material = obj.materials[source.material];
+                if (!material.diffuseMap.empty())
+                    textures.push_back(textureReference(material.diffuseMap.c_str(), "texture_diffuse"));
+                if (!material.specularMap.empty())
+                    textures.push_back(textureReference(material.specularMap.c_str(), "texture_specular"));
+                if (!material.bumpMap.empty())
+                    textures.push_back(textureReference(material.bumpMap.c_str(), "texture_normal"));
+                if (!material.ambientMap.empty())
+                    textures.push_back(textureReference(material.ambientMap.c_str(), "texture_height"));
+            }
+            meshes.push_back(Mesh(vertices, source.indices, textures, true));
+        }
+    }
+
+    // ASSIMPOBJȡд뻺棬´ʱʹ
+    void writeCache(string const &path, uint32_t importer, uint64_t sourceHash, uint64_t sourceSize)
+    {
+        vector<MeshCacheData> data(meshes.size());
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            data[i].vertices = meshes[i].vertices.data();
+            data[i].vertexCount = static_cast<uint32_t>(meshes[i].vertices.size());
+            data[i].indices = meshes[i].indices.data();
+            data[i].indexCount = static_cast<uint32_t>(meshes[i].indices.size());
+            for (const Texture& texture : meshes[i].textures)
+            {
+                MeshCacheTexture entry;
+                if (!makeMeshCacheTexture(texture.type, texture.path, entry))
+                    return;
+                data[i].textures.push_back(entry);
+            }
+        }
+        MeshCacheHeader header;
+        memset(&header, 0, sizeof(header));
+        header.importFlags = MODEL_IMPORT_FLAGS;
+        header.vertexStride = sizeof(Vertex);
+        header.importer = importer;
+        header.sourceHash = sourceHash;
+        header.sourceSize = sourceSize;
+        if (!writeMeshCache(meshCachePath(path), header, data))
+            cout << "Mesh cache failed to write at path: " << meshCachePath(path) << endl;
     }
 
     // ݹ鴦ڵ㡣ڵϵÿ񣬲ӽڵظ˹̣У
@@ -96,7 +245,7 @@ private:
         // ÿĶ
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = Vertex();   // ֵʼδʹõĹΪ0񻺴ݿɸ
             glm::vec3 vector;
             vector.x = mesh->mVertices[i].x;
             vector.y = mesh->mVertices[i].y;
@@ -158,11 +307,10 @@ private:
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
         // شȡݴ
-        return Mesh(vertices, indices, textures);
+        return Mesh(vertices, indices, textures, true);
     }
 
-    // ͵вδص
-    // ϢΪһṹ
+    // ռ͵вuploadMeshes()м
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
     {
         vector<Texture> textures;
@@ -170,29 +318,39 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // ֮ǰǷǣһ:
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true;
-                    break;
-                }
-            }
-            if(!skip)
-            {   // δأ
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);
-            }
+            textures.push_back(textureReference(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // δصãidΪ0GL
+    static Texture textureReference(const char *path, const string &typeName)
+    {
+        Texture texture;
+        texture.id = 0;
+        texture.type = typeName;
+        texture.path = path;
+        return texture;
+    }
+
+    // ģĿ¼µһŲ
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        // ֮ǰǷֱӸ
+        auto found = textures_index.find(path);
+        if (found != textures_index.end())
+            return textures_loaded[found->second];
+        // δأͨȫȡģѼصͬһͼֱӹ
+        Texture texture;
+        texture.id = TextureCache::instance().acquire(this->directory + '/' + path, false, [&](const string& filename) {
+            return streamer ? streamer->request(filename) : TextureFromFile(path, this->directory);
+        });
+        texture.type = typeName;
+        texture.path = path;
+        textures_index[path] = textures_loaded.size();
+        textures_loaded.push_back(texture);
+        return texture;
+    }
 };
 
 
@@ -204,34 +362,8 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
+    if (!loadTexture2D(textureID, filename))
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
 
     return textureID;
 }
@@ -0,0 +1,158 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <model.h>
+#include <texture_streamer.h>
+#include <thread_pool.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// ######################################
+// # Class ModelLoader
+// ######################################
+// ģͣ루񻺴/OBJ/ASSIMP㴦̳߳вִУ
+// غsetupMeshGLŶӣGL߳processUploads()/finish()ִС
+// pool봫ModelmeshPoolͬȴOBJֿʱռй߳
+class ModelLoader
+{
+public:
+    ModelLoader(ThreadPool& pool, TextureStreamer* streamer = nullptr, ThreadPool* meshPool = nullptr)
+        : pool(pool), streamer(streamer), meshPool(meshPool), inFlight(0), loadedCount(0), uploadMs(0.0)
+    {
+    }
+
+    // ύһģͣصfutureGLϴɺ
+    std::future<std::unique_ptr<Model>> load(const std::string& path, bool gamma = false)
+    {
+        std::shared_ptr<std::promise<std::unique_ptr<Model>>> promise = std::make_shared<std::promise<std::unique_ptr<Model>>>();
+        std::future<std::unique_ptr<Model>> result = promise->get_future();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (inFlight++ == 0)
+                loadStart = std::chrono::high_resolution_clock::now();
+        }
+        pool.enqueue([this, path, gamma, promise] {
+            PendingModel pending;
+            pending.path = path;
+            pending.promise = promise;
+            try
+            {
+                pending.model.reset(new Model(path, gamma, streamer, meshPool, true));
+            }
+            catch (...)
+            {
+                pending.error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(queueMutex);
+            importEnd = std::chrono::high_resolution_clock::now();
+            ready.push_back(std::move(pending));
+            condition.notify_one();
+        });
+        return result;
+    }
+
+    // GL̵߳ãϴɵģͣȴڵģ͡رϴ
+    unsigned int processUploads()
+    {
+        unsigned int count = 0;
+        for (;;)
+        {
+            PendingModel pending;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (ready.empty())
+                    return count;
+                pending = std::move(ready.front());
+                ready.pop_front();
+            }
+            upload(pending);
+            count++;
+        }
+    }
+
+    // GL̵߳ãȴϴȫύģͣʱͳơ
+    // pollΪʱȴڼԼÿһΣ̨ɵɫ
+    void finish(const std::function<void()>& poll = std::function<void()>())
+    {
+        for (;;)
+        {
+            PendingModel pending;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                if (inFlight == 0)
+                    break;
+                if (poll)
+                {
+                    if (!condition.wait_for(lock, std::chrono::milliseconds(1), [this] { return !ready.empty(); }))
+                    {
+                        lock.unlock();
+                        poll();
+                        continue;
+                    }
+                }
+                else
+                    condition.wait(lock, [this] { return !ready.empty(); });
+                pending = std::move(ready.front());
+                ready.pop_front();
+            }
+            upload(pending);
+        }
+
+        double importWallMs = std::chrono::duration<double, std::milli>(importEnd - loadStart).count();
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        std::cout << "ModelLoader: " << loadedCount << " models, " << pool.size() << " threads | import wall " << std::fixed
+                  << std::setprecision(1) << importWallMs << " ms | GL upload " << uploadMs << " ms | total " << totalMs
+                  << " ms" << std::defaultfloat << std::endl;
+        loadedCount = 0;
+        uploadMs = 0.0;
+    }
+
+private:
+    struct PendingModel {
+        std::string path;
+        std::unique_ptr<Model> model;
+        std::exception_ptr error;
+        std::shared_ptr<std::promise<std::unique_ptr<Model>>> promise;
+    };
+
+    ThreadPool& pool;
+    TextureStreamer* streamer;
+    ThreadPool* meshPool;
+
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    std::deque<PendingModel> ready;         // ѵ롢ȴGLϴģ
+    unsigned int inFlight;                  // ύδϴģ
+
+    unsigned int loadedCount;
+    double uploadMs;
+    std::chrono::high_resolution_clock::time_point loadStart;
+    std::chrono::high_resolution_clock::time_point importEnd;
+
+    void upload(PendingModel& pending)
+    {
+        if (pending.error)
+            pending.promise->set_exception(pending.error);
+        else
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            pending.model->uploadMeshes();
+            uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            loadedCount++;
+            pending.promise->set_value(std::move(pending.model));
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        inFlight--;
+    }
+};
+#endif
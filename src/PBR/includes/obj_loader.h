@@ -0,0 +1,646 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <file_system.h>
+#include <mapped_file.h>
+#include <thread_pool.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// õOBJ/MTLȡļб߽п̳߳внASSIMP
+// (Triangulate | GenSmoothNormals | FlipUVs | CalcTangentSpace) ͬ񻮷ֺͶ㲼֣
+// ÿobjectڰusemtl񣬶ΰǻÿһ㣬˳
+
+struct ObjVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+};
+
+// MTLModelõͼ·ģĿ¼ûʱΪ
+struct ObjMaterial {
+    std::string name;
+    std::string diffuseMap;     // map_Kd
+    std::string specularMap;    // map_Ks
+    std::string bumpMap;        // map_bump / map_Bump / bump
+    std::string ambientMap;     // map_Ka
+};
+
+struct ObjMesh {
+    std::string name;
+    int material;               // materialsе±꣬ûвʱΪ-1
+    bool hasTexCoords;          // ʱż
+    std::vector<ObjVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+struct ObjModel {
+    std::vector<ObjMesh> meshes;
+    std::vector<ObjMaterial> materials;
+};
+
+struct ObjLoadOptions {
+    bool flipUVs = true;            // v = 1 - v
+    bool generateNormals = true;    // ȫûзʱƽ
+    bool calcTangents = true;       // ߺ͸
+};
+
+// õĶ±꣬0ʼ-1Ϊȱʧ
+// ʱֻԿڼӦλrelative1ϲʱϿʼλûΪȫ±
+struct ObjCorner {
+    int position;
+    int texCoord;
+    int normal;
+    unsigned int relative;      // 1: position2: texCoord4: normal
+};
+
+// 񻮷¼ӵtriangleлobject
+struct ObjGroupEvent {
+    size_t triangle;
+    bool object;                // trueΪofalseΪusemtl
+    std::string name;
+};
+
+// Ľ
+struct ObjChunk {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;         // ǻÿ3Ϊһ
+    std::vector<ObjGroupEvent> events;
+    std::vector<std::string> materialLibraries;
+    std::string error;
+};
+
+inline bool isObjSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipObjSpaces(const char* p, const char* end)
+{
+    while (p < end && isObjSpace(*p))
+        p++;
+    return p;
+}
+
+// ٸβۻΪ64λٳ10ݣlocale
+inline bool parseObjFloat(const char*& p, const char* end, float& value)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    p = skipObjSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+    {
+        if (mantissa < 100000000000000000ull)
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+        {
+            if (mantissa < 100000000000000000ull)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0)
+        return false;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            negativeExponent = *q++ == '-';
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++)
+                e = std::min(e * 10 + (*q - '0'), 1000);
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0)
+        result = -exponent <= 22 ? result / powers[-exponent] : result * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        result = exponent <= 22 ? result * powers[exponent] : result * std::pow(10.0, exponent);
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+inline bool parseObjInt(const char*& p, const char* end, int& value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p >= end || *p < '0' || *p > '9')
+        return false;
+    int result = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+        result = result * 10 + (*p - '0');
+    value = negative ? -result : result;
+    return true;
+}
+
+// OBJ±꣨1ʼԵǰλãתΪObjCorner±꣬Ϊ
+inline int encodeObjIndex(int index, size_t localCount, unsigned int bit, unsigned int& relative)
+{
+    if (index > 0)
+        return index - 1;
+    relative |= bit;
+    return (int)localCount + index;
+}
+
+// ʣಿ֣ȥβհףֺ·
+inline std::string objRestOfLine(const char* p, const char* end)
+{
+    p = skipObjSpaces(p, end);
+    while (end > p && isObjSpace(end[-1]))
+        end--;
+    return std::string(p, end);
+}
+
+// [begin, end)ڵ
+inline void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    std::vector<ObjCorner> polygon;
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+        const char* p = skipObjSpaces(line, lineEnd);
+        line = lineEnd + 1;
+        if (p >= lineEnd || *p == '#')
+            continue;
+
+        const char* keyword = p;
+        while (p < lineEnd && !isObjSpace(*p))
+            p++;
+        size_t keywordLength = p - keyword;
+        if (keywordLength == 1 && keyword[0] == 'v')
+        {
+            glm::vec3 v;
+            if (!parseObjFloat(p, lineEnd, v.x) || !parseObjFloat(p, lineEnd, v.y) || !parseObjFloat(p, lineEnd, v.z))
+            {
+                chunk.error = "invalid vertex position";
+                return;
+            }
+            chunk.positions.push_back(v);
+        }
+        else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 't')
+        {
+            glm::vec2 vt(0.0f);
+            if (!parseObjFloat(p, lineEnd, vt.x))
+            {
+                chunk.error = "invalid texture coordinate";
+                return;
+            }
+            parseObjFloat(p, lineEnd, vt.y);
+            chunk.texCoords.push_back(vt);
+        }
+        else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+        {
+            glm::vec3 vn;
+            if (!parseObjFloat(p, lineEnd, vn.x) || !parseObjFloat(p, lineEnd, vn.y) || !parseObjFloat(p, lineEnd, vn.z))
+            {
+                chunk.error = "invalid vertex normal";
+                return;
+            }
+            chunk.normals.push_back(vn);
+        }
+        else if (keywordLength == 1 && keyword[0] == 'f')
+        {
+            polygon.clear();
+            for (;;)
+            {
+                p = skipObjSpaces(p, lineEnd);
+                if (p >= lineEnd)
+                    break;
+                ObjCorner corner = { -1, -1, -1, 0 };
+                int index;
+                if (!parseObjInt(p, lineEnd, index) || index == 0)
+                {
+                    chunk.error = "invalid face";
+                    return;
+                }
+                corner.position = encodeObjIndex(index, chunk.positions.size(), 1, corner.relative);
+                if (p < lineEnd && *p == '/')
+                {
+                    p++;
+                    if (p < lineEnd && *p != '/' && parseObjInt(p, lineEnd, index) && index != 0)
+                        corner.texCoord = encodeObjIndex(index, chunk.texCoords.size(), 2, corner.relative);
+                    if (p < lineEnd && *p == '/')
+                    {
+                        p++;
+                        if (parseObjInt(p, lineEnd, index) && index != 0)
+                            corner.normal = encodeObjIndex(index, chunk.normals.size(), 4, corner.relative);
+                    }
+                }
+                polygon.push_back(corner);
+            }
+            // ǻaiProcess_Triangulate͹εĽһ
+            for (size_t i = 2; i < polygon.size(); i++)
+            {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+        else if (keywordLength == 1 && keyword[0] == 'o')
+        {
+            ObjGroupEvent event = { chunk.corners.size() / 3, true, objRestOfLine(p, lineEnd) };
+            chunk.events.push_back(event);
+        }
+        else if (keywordLength == 6 && memcmp(keyword, "usemtl", 6) == 0)
+        {
+            ObjGroupEvent event = { chunk.corners.size() / 3, false, objRestOfLine(p, lineEnd) };
+            chunk.events.push_back(event);
+        }
+        else if (keywordLength == 6 && memcmp(keyword, "mtllib", 6) == 0)
+        {
+            std::istringstream names(objRestOfLine(p, lineEnd));
+            std::string name;
+            while (names >> name)
+                chunk.materialLibraries.push_back(name);
+        }
+        // 䣨gslȣӰ
+    }
+}
+
+// MTLļ׷ӵmaterialsͼѡ-bm 1.0ȣȡһΪ·
+inline void loadObjMaterials(const std::string& path, std::vector<ObjMaterial>& materials)
+{
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#')
+            continue;
+        std::string value, token;
+        while (tokens >> token)
+            value = token;
+        if (keyword == "newmtl")
+        {
+            materials.push_back(ObjMaterial());
+            materials.back().name = objRestOfLine(line.c_str() + line.find("newmtl") + 6, line.c_str() + line.size());
+        }
+        else if (materials.empty())
+            continue;
+        else if (keyword == "map_Kd")
+            materials.back().diffuseMap = value;
+        else if (keyword == "map_Ks")
+            materials.back().specularMap = value;
+        else if (keyword == "map_bump" || keyword == "map_Bump" || keyword == "bump")
+            materials.back().bumpMap = value;
+        else if (keyword == "map_Ka")
+            materials.back().ambientMap = value;
+    }
+}
+
+// һȫеķΧ
+struct ObjMeshRange {
+    std::string name;
+    std::string material;
+    size_t firstTriangle;
+    size_t triangleCount;
+};
+
+// ȫ񶥵㣺ȡԡתUVҪʱƽߣASSIMP CalcTangentSpaceķ
+inline bool buildObjMesh(const std::vector<ObjCorner>& corners, const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+                         const std::vector<glm::vec3>& normals, size_t firstTriangle, size_t triangleCount, const ObjLoadOptions& options, ObjMesh& mesh)
+{
+    size_t vertexCount = triangleCount * 3;
+    const ObjCorner* meshCorners = corners.data() + firstTriangle * 3;
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(vertexCount);
+    mesh.hasTexCoords = false;
+    bool hasNormals = false;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const ObjCorner& corner = meshCorners[i];
+        if (corner.position < 0 || (size_t)corner.position >= positions.size()
+            || (corner.texCoord >= 0 && (size_t)corner.texCoord >= texCoords.size())
+            || (corner.normal >= 0 && (size_t)corner.normal >= normals.size()))
+            return false;
+        ObjVertex& vertex = mesh.vertices[i];
+        vertex = ObjVertex();
+        vertex.position = positions[corner.position];
+        if (corner.texCoord >= 0)
+        {
+            vertex.texCoords = texCoords[corner.texCoord];
+            if (options.flipUVs)
+                vertex.texCoords.y = 1.0f - vertex.texCoords.y;
+            mesh.hasTexCoords = true;
+        }
+        if (corner.normal >= 0)
+        {
+            vertex.normal = normals[corner.normal];
+            hasNormals = true;
+        }
+        mesh.indices[i] = static_cast<unsigned int>(i);
+    }
+
+    // λ±ǣڲͬһλϵĶ
+    std::vector<std::pair<int, unsigned int>> byPosition(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+        byPosition[i] = std::make_pair(meshCorners[i].position, static_cast<unsigned int>(i));
+    std::sort(byPosition.begin(), byPosition.end());
+
+    // GenSmoothNormalsASSIMPֻͬȫûзʱɣͬһλõ淨ȡƽ
+    // ȱٷʱļеķߣȱٵΪ0
+    if (!hasNormals && options.generateNormals)
+    {
+        std::vector<glm::vec3> faceNormals(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const ObjVertex* v = &mesh.vertices[t * 3];
+            glm::vec3 n = glm::cross(v[1].position - v[0].position, v[2].position - v[0].position);
+            float length = glm::length(n);
+            faceNormals[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+        }
+        for (size_t begin = 0; begin < vertexCount;)
+        {
+            size_t end = begin;
+            glm::vec3 sum(0.0f);
+            for (; end < vertexCount && byPosition[end].first == byPosition[begin].first; end++)
+                sum += faceNormals[byPosition[end].second / 3];
+            float length = glm::length(sum);
+            glm::vec3 normal = length > 0.0f ? sum / length : glm::vec3(0.0f);
+            for (size_t i = begin; i < end; i++)
+                mesh.vertices[byPosition[i].second].normal = normal;
+            begin = end;
+        }
+    }
+
+    if (!mesh.hasTexCoords || !options.calcTangents)
+        return true;
+
+    // ÿεߺ͸ߣͶӰ㷨ߵƽ
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        ObjVertex* v = &mesh.vertices[t * 3];
+        glm::vec3 e1 = v[1].position - v[0].position;
+        glm::vec3 e2 = v[2].position - v[0].position;
+        float sx = v[1].texCoords.x - v[0].texCoords.x, sy = v[1].texCoords.y - v[0].texCoords.y;
+        float tx = v[2].texCoords.x - v[0].texCoords.x, ty = v[2].texCoords.y - v[0].texCoords.y;
+        float direction = (tx * sy - ty * sx) < 0.0f ? -1.0f : 1.0f;
+        // UV˻ʱʹĬϷ
+        if (sx * ty == sy * tx)
+        {
+            sx = 0.0f; sy = 1.0f;
+            tx = 1.0f; ty = 0.0f;
+        }
+        glm::vec3 tangent = (e2 * sy - e1 * ty) * direction;
+        glm::vec3 bitangent = (e2 * sx - e1 * tx) * direction;
+        for (int c = 0; c < 3; c++)
+        {
+            const glm::vec3& n = v[c].normal;
+            glm::vec3 localTangent = tangent - n * glm::dot(tangent, n);
+            glm::vec3 localBitangent = bitangent - n * glm::dot(bitangent, n);
+            float tangentLength = glm::length(localTangent);
+            float bitangentLength = glm::length(localBitangent);
+            // ޷ʱȡ뷨ߴֱⷽ
+            if (!(tangentLength > 1e-12f) || !(bitangentLength > 1e-12f))
+            {
+                glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                localTangent = glm::cross(n, axis);
+                tangentLength = glm::length(localTangent);
+                localBitangent = glm::cross(n, localTangent);
+                bitangentLength = glm::length(localBitangent);
+            }
+            v[c].tangent = tangentLength > 0.0f ? localTangent / tangentLength : glm::vec3(0.0f);
+            v[c].bitangent = bitangentLength > 0.0f ? localBitangent / bitangentLength : glm::vec3(0.0f);
+        }
+    }
+
+    // ͬһλϷߡߡ߼нǶС45ȵĶƽ߿ռ
+    const float limit = std::cos(glm::radians(45.0f));
+    std::vector<glm::vec3> smoothTangents(vertexCount), smoothBitangents(vertexCount);
+    std::vector<unsigned int> group;
+    for (size_t begin = 0; begin < vertexCount;)
+    {
+        size_t end = begin;
+        while (end < vertexCount && byPosition[end].first == byPosition[begin].first)
+            end++;
+        for (size_t i = begin; i < end; i++)
+        {
+            const ObjVertex& reference = mesh.vertices[byPosition[i].second];
+            glm::vec3 tangentSum(0.0f), bitangentSum(0.0f);
+            for (size_t j = begin; j < end; j++)
+            {
+                const ObjVertex& other = mesh.vertices[byPosition[j].second];
+                if (glm::dot(reference.normal, other.normal) >= limit && glm::dot(reference.tangent, other.tangent) >= limit
+                    && glm::dot(reference.bitangent, other.bitangent) >= limit)
+                {
+                    tangentSum += other.tangent;
+                    bitangentSum += other.bitangent;
+                }
+            }
+            float tangentLength = glm::length(tangentSum);
+            float bitangentLength = glm::length(bitangentSum);
+            smoothTangents[byPosition[i].second] = tangentLength > 0.0f ? tangentSum / tangentLength : reference.tangent;
+            smoothBitangents[byPosition[i].second] = bitangentLength > 0.0f ? bitangentSum / bitangentLength : reference.bitangent;
+        }
+        begin = end;
+    }
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        mesh.vertices[i].tangent = smoothTangents[i];
+        mesh.vertices[i].bitangent = smoothBitangents[i];
+    }
+    return true;
+}
+
+// ȡOBJļõMTLpoolΪʱп鲢нͲ񣨲poolԼеã
+// ʧʱfalseerrorиԭ
+inline bool loadObj(const std::string& path, ObjModel& model, ThreadPool* pool, std::string& error, const ObjLoadOptions& options = ObjLoadOptions())
+{
+    model = ObjModel();
+    MappedFile file;
+    if (!file.open(path))
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const char* dataEnd = data + file.size();
+
+    // б߽п飬ÿ256KB
+    const size_t minChunkSize = 256 * 1024;
+    size_t chunkCount = pool ? std::max<size_t>(1, std::min<size_t>(pool->size() * 4, file.size() / minChunkSize)) : 1;
+    std::vector<const char*> bounds(1, data);
+    for (size_t i = 1; i < chunkCount; i++)
+    {
+        const char* p = std::max(bounds.back(), data + file.size() * i / chunkCount);
+        const char* newline = static_cast<const char*>(memchr(p, '\n', dataEnd - p));
+        if (!newline)
+            break;
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(dataEnd);
+    chunkCount = bounds.size() - 1;
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        if (pool && chunkCount > 1)
+            tasks.push_back(pool->enqueue([&, i] { parseObjChunk(bounds[i], bounds[i + 1], chunks[i]); }));
+        else
+            parseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].get();
+    tasks.clear();
+
+    // ȫеʼλ
+    std::vector<size_t> positionBase(chunkCount + 1, 0), texCoordBase(chunkCount + 1, 0), normalBase(chunkCount + 1, 0), cornerBase(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        if (!chunks[i].error.empty())
+        {
+            error = chunks[i].error + " in " + path;
+            return false;
+        }
+        positionBase[i + 1] = positionBase[i] + chunks[i].positions.size();
+        texCoordBase[i + 1] = texCoordBase[i] + chunks[i].texCoords.size();
+        normalBase[i + 1] = normalBase[i] + chunks[i].normals.size();
+        cornerBase[i + 1] = cornerBase[i] + chunks[i].corners.size();
+    }
+
+    // кϲȫ飬ͬʱѿ±껻Ϊȫ±
+    std::vector<glm::vec3> positions(positionBase[chunkCount]);
+    std::vector<glm::vec2> texCoords(texCoordBase[chunkCount]);
+    std::vector<glm::vec3> normals(normalBase[chunkCount]);
+    std::vector<ObjCorner> corners(cornerBase[chunkCount]);
+    auto merge = [&](size_t i) {
+        const ObjChunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionBase[i]);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + texCoordBase[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalBase[i]);
+        // Ϊ±Խ磬Ϊֵʹʱ
+        auto resolve = [](int index, size_t base) { index += (int)base; return index < 0 ? INT_MAX : index; };
+        for (size_t c = 0; c < chunk.corners.size(); c++)
+        {
+            ObjCorner corner = chunk.corners[c];
+            if (corner.relative & 1)
+                corner.position = resolve(corner.position, positionBase[i]);
+            if (corner.relative & 2)
+                corner.texCoord = resolve(corner.texCoord, texCoordBase[i]);
+            if (corner.relative & 4)
+                corner.normal = resolve(corner.normal, normalBase[i]);
+            corner.relative = 0;
+            corners[cornerBase[i] + c] = corner;
+        }
+    };
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        if (pool && chunkCount > 1)
+            tasks.push_back(pool->enqueue([&, i] { merge(i); }));
+        else
+            merge(i);
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].get();
+    tasks.clear();
+
+    // ʿ
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+    for (size_t i = 0; i < chunkCount; i++)
+        for (size_t j = 0; j < chunks[i].materialLibraries.size(); j++)
+            loadObjMaterials(directory + chunks[i].materialLibraries[j], model.materials);
+
+    // ousemtl¼ASSIMPһobjectʱ仯ʱʼ
+    std::vector<ObjMeshRange> ranges;
+    ObjMeshRange current = { "defaultobject", std::string(), 0, 0 };
+    auto closeRange = [&](size_t triangle) {
+        current.triangleCount = triangle - current.firstTriangle;
+        if (current.triangleCount > 0)
+            ranges.push_back(current);
+        current.firstTriangle = triangle;
+    };
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        for (size_t e = 0; e < chunks[i].events.size(); e++)
+        {
+            const ObjGroupEvent& event = chunks[i].events[e];
+            size_t triangle = cornerBase[i] / 3 + event.triangle;
+            if (event.object)
+            {
+                closeRange(triangle);
+                current.name = event.name;
+            }
+            else if (event.name != current.material)
+            {
+                closeRange(triangle);
+                current.material = event.name;
+            }
+        }
+    }
+    closeRange(corners.size() / 3);
+
+    model.meshes.resize(ranges.size());
+    std::vector<char> built(ranges.size(), 0);
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        ObjMesh& mesh = model.meshes[i];
+        mesh.name = ranges[i].name;
+        mesh.material = -1;
+        for (size_t m = 0; m < model.materials.size(); m++)
+            if (model.materials[m].name == ranges[i].material)
+                mesh.material = static_cast<int>(m);
+        auto build = [&, i] {
+            built[i] = buildObjMesh(corners, positions, texCoords, normals, ranges[i].firstTriangle, ranges[i].triangleCount, options, model.meshes[i]);
+        };
+        if (pool && ranges.size() > 1)
+            tasks.push_back(pool->enqueue(build));
+        else
+            build();
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].get();
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        if (!built[i])
+        {
+            error = "face index out of range in " + path;
+            return false;
+        }
+    }
+    if (model.meshes.empty())
+    {
+        error = "no faces in " + path;
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,43 @@
+#ifndef PARALLEL_SHADER_COMPILE_H
+#define PARALLEL_SHADER_COMPILE_H
+
+#include <glad/glad.h>
+
+#include <gl_extensions.h>
+
+// KHR_parallel_shader_compileͬARBչԼ߳бӣ
+// glCompileShader/glLinkProgramأ֮GL_COMPLETION_STATUS_KHRѯǷɶ
+// gladֻ3.3ĵļöٺͺҪԼͼ
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+struct GLParallelShaderCompileFunctions {
+    void (APIENTRYP maxShaderCompilerThreads)(GLuint count) = nullptr;
+    bool supported = false;
+};
+
+inline GLParallelShaderCompileFunctions& glParallelShaderCompile()
+{
+    static GLParallelShaderCompileFunctions functions;
+    return functions;
+}
+
+// Ⲣòб룬֧߳ʱfalseӳٴShaderȻЧֻڵһʹʱͬ
+inline bool loadGLParallelShaderCompile(GLADloadproc load)
+{
+    GLParallelShaderCompileFunctions& functions = glParallelShaderCompile();
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        functions.maxShaderCompilerThreads = reinterpret_cast<void (APIENTRYP)(GLuint)>(load("glMaxShaderCompilerThreadsKHR"));
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        functions.maxShaderCompilerThreads = reinterpret_cast<void (APIENTRYP)(GLuint)>(load("glMaxShaderCompilerThreadsARB"));
+    functions.supported = functions.maxShaderCompilerThreads != nullptr;
+    // 0xFFFFFFFFʾѡ߳
+    if (functions.supported)
+        functions.maxShaderCompilerThreads(0xFFFFFFFFu);
+    return functions.supported;
+}
+#endif
@@ -0,0 +1,163 @@
+#ifndef PROGRAM_BINARY_H
+#define PROGRAM_BINARY_H
+
+#include <glad/glad.h>
+
+#include <content_hash.h>
+#include <mapped_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ӺõɫĶƻ棨.progbinglGetProgramBinary棬´glProgramBinaryֱӼأӡ
+// ɫԴ루ĺ궨壩GL_VENDOR/GL_RENDERER/GL_VERSIONַĹϣΪ
+// Դ仯ܾöʱ˻벢ǻ
+const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+// GL 4.1/ARB_get_program_binaryöٺͺgladֻ3.3ĵļҪԼͼ
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+struct GLProgramBinaryFunctions {
+    void (APIENTRYP getProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) = nullptr;
+    void (APIENTRYP programBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) = nullptr;
+    void (APIENTRYP programParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+    bool supported = false;
+};
+
+inline GLProgramBinaryFunctions& glProgramBinaries()
+{
+    static GLProgramBinaryFunctions functions;
+    return functions;
+}
+
+// ôϵͳĺسغ֧κζƸʽʱfalseʱShaderǴԴ
+inline bool loadGLProgramBinary(GLADloadproc load)
+{
+    GLProgramBinaryFunctions& functions = glProgramBinaries();
+    functions.getProgramBinary = reinterpret_cast<void (APIENTRYP)(GLuint, GLsizei, GLsizei*, GLenum*, void*)>(load("glGetProgramBinary"));
+    functions.programBinary = reinterpret_cast<void (APIENTRYP)(GLuint, GLenum, const void*, GLsizei)>(load("glProgramBinary"));
+    functions.programParameteri = reinterpret_cast<void (APIENTRYP)(GLuint, GLenum, GLint)>(load("glProgramParameteri"));
+    // ָ֧չʱѯGL_INVALID_ENUM0
+    GLint formatCount = 0;
+    if (functions.getProgramBinary && functions.programBinary && functions.programParameteri)
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        while (glGetError() != GL_NO_ERROR)
+            ;
+    }
+    functions.supported = formatCount > 0;
+    return functions.supported;
+}
+
+struct ProgramBinaryHeader {
+    char magic[4];          // "PBRP"
+    uint32_t version;
+    uint64_t key;           // ԴַĹϣ
+    uint32_t binaryFormat;
+    uint32_t binarySize;
+};
+
+// ƻ·Ƭɫԣļд϶/ɫ·ͺ궨ĹϣֹƬɫĳͱ
+inline std::string programBinaryPath(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const std::string& defines)
+{
+    std::string variant = std::string(vertexPath) + '\n' + (geometryPath ? geometryPath : "") + '\n' + defines;
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%08x.progbin", static_cast<uint32_t>(hashBytes(variant.data(), variant.size())));
+    return std::string(fragmentPath) + suffix;
+}
+
+// ׶Դ뵱ǰĹϣºɵĶԶʧЧ
+inline uint64_t programBinaryKey(const std::vector<std::string>& sources)
+{
+    uint64_t key = hashBytes(&PROGRAM_BINARY_VERSION, sizeof(PROGRAM_BINARY_VERSION));
+    const GLenum strings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : strings)
+    {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        if (value)
+            key = hashBytes(value, strlen(value), key);
+    }
+    for (const std::string& source : sources)
+        key = hashBytes(source.data(), source.size(), key);
+    return key;
+}
+
+// ӻ洴򣬻治ڡһ»ܾöʱ0
+inline unsigned int loadProgramBinary(const std::string& path, uint64_t key)
+{
+    if (!glProgramBinaries().supported)
+        return 0;
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(ProgramBinaryHeader))
+        return 0;
+    const ProgramBinaryHeader* header = reinterpret_cast<const ProgramBinaryHeader*>(file.data());
+    if (memcmp(header->magic, "PBRP", 4) != 0 || header->version != PROGRAM_BINARY_VERSION || header->key != key
+        || header->binarySize > file.size() - sizeof(ProgramBinaryHeader))
+        return 0;
+    unsigned int program = glCreateProgram();
+    glProgramBinaries().programBinary(program, header->binaryFormat, file.data() + sizeof(ProgramBinaryHeader), static_cast<GLsizei>(header->binarySize));
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// ǰãʾɶصĶ
+inline void markProgramBinaryRetrievable(unsigned int program)
+{
+    if (glProgramBinaries().supported)
+        glProgramBinaries().programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+// ӳĶд뻺棨дʱļ滻
+inline bool saveProgramBinary(const std::string& path, uint64_t key, unsigned int program)
+{
+    if (!glProgramBinaries().supported)
+        return false;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    glProgramBinaries().getProgramBinary(program, length, &written, &binaryFormat, binary.data());
+    if (written <= 0)
+        return false;
+
+    ProgramBinaryHeader header;
+    memcpy(header.magic, "PBRP", 4);
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(written);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file.good())
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+#endif
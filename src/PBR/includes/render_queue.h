@@ -0,0 +1,79 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 64λӸߵͣ8λ| ʣ16λ| 16λ| ȣ24λ
+// ͬĻڣͬʵڣٰVAO飬ͬһɽԶ
+// ȡǸλģʽĸ24λλģʽĴС˳ֵһ
+inline uint64_t makeSortKey(uint32_t program, uint32_t material, uint32_t mesh, float depth)
+{
+    if (!(depth > 0.0f))
+        depth = 0.0f;
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    return (static_cast<uint64_t>(program & 0xFFu) << 56)
+         | (static_cast<uint64_t>(material & 0xFFFFu) << 40)
+         | (static_cast<uint64_t>(mesh & 0xFFFFu) << 24)
+         | static_cast<uint64_t>(depthBits >> 8);
+}
+
+// ######################################
+// # Class RenderQueue
+// ######################################
+// ÿ֡ĻƶУύʱֻ¼ͻƶ±꣬sort()LSDÿ8λ
+// ʱύԹϵмĳֽ϶ͬʱ
+class RenderQueue
+{
+public:
+    struct Item {
+        uint64_t key;
+        uint32_t renderable;
+        uint32_t mesh;
+    };
+
+    void clear()
+    {
+        queue.clear();
+    }
+
+    void submit(uint64_t key, uint32_t renderable, uint32_t mesh)
+    {
+        queue.push_back(Item{ key, renderable, mesh });
+    }
+
+    void sort()
+    {
+        scratch.resize(queue.size());
+        for (unsigned int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = {};
+            for (const Item& item : queue)
+                counts[(item.key >> shift) & 0xFF]++;
+            if (queue.empty() || counts[(queue[0].key >> shift) & 0xFF] == queue.size())
+                continue;
+            size_t offset = 0;
+            for (size_t& count : counts)
+            {
+                size_t bucket = count;
+                count = offset;
+                offset += bucket;
+            }
+            for (const Item& item : queue)
+                scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+            queue.swap(scratch);
+        }
+    }
+
+    const std::vector<Item>& items() const
+    {
+        return queue;
+    }
+
+private:
+    std::vector<Item> queue;
+    std::vector<Item> scratch;
+};
+#endif
@@ -0,0 +1,258 @@
+#ifndef SCENE_REGISTRY_H
+#define SCENE_REGISTRY_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <gl_state_cache.h>
+#include <material.h>
+#include <mesh_batch.h>
+#include <model.h>
+#include <render_queue.h>
+#include <shader.h>
+#include <uniform_buffer.h>
+
+#include <cstdint>
+#include <vector>
+
+// עжľֻ±꣬Tagֲͬ࣬
+template<class Tag>
+struct RegistryHandle {
+    uint32_t index = UINT32_MAX;
+
+    bool valid() const
+    {
+        return index != UINT32_MAX;
+    }
+};
+
+struct ModelTag {};
+struct MaterialTag {};
+struct RenderableTag {};
+typedef RegistryHandle<ModelTag> ModelHandle;
+typedef RegistryHandle<MaterialTag> MaterialHandle;
+typedef RegistryHandle<RenderableTag> RenderableHandle;
+
+// һdraw()ͳ
+struct SceneDrawStats {
+    unsigned int draws = 0;
+    unsigned int programChanges = 0;
+    unsigned int materialChanges = 0;
+};
+
+// ######################################
+// # Class SceneRegistry
+// ######################################
+// пȾעģ͡ʺͱ任עһΣֻ֮ͨá
+// ģעʱֻ¼VAOModelÿ֡ĻֻȡGLID
+// ʱ붥޹ء߾ñ任ʱһΣʱģ;һдUniformRingObjectUniforms顣
+// ÿ֡񰴣򣬲ʣȣύRenderQueueƣ
+// ˳ע˳޹أͲֻڻƲͬʱл
+class SceneRegistry
+{
+public:
+    // עһϴuploadMeshes()֮󣩵ģ
+    ModelHandle addModel(const Model& model)
+    {
+        ModelRecord record;
+        record.firstMesh = static_cast<uint32_t>(meshes.size());
+        for (const Mesh& mesh : model.meshes)
+            meshes.push_back(MeshDraw{ mesh.VAO, static_cast<GLsizei>(mesh.indexCount) });
+        record.meshCount = static_cast<uint32_t>(meshes.size()) - record.firstMesh;
+        models.push_back(record);
+        ModelHandle handle;
+        handle.index = static_cast<uint32_t>(models.size()) - 1;
+        return handle;
+    }
+
+    // עһѹĺϲΪֻһģ
+    ModelHandle addModel(const MeshBatch& batch)
+    {
+        ModelRecord record;
+        record.firstMesh = static_cast<uint32_t>(meshes.size());
+        record.meshCount = 1;
+        meshes.push_back(MeshDraw{ batch.VAO, static_cast<GLsizei>(batch.indexCount) });
+        models.push_back(record);
+        ModelHandle handle;
+        handle.index = static_cast<uint32_t>(models.size()) - 1;
+        return handle;
+    }
+
+    // עһʣʹͬɫĲʹһ
+    MaterialHandle addMaterial(const Material& material)
+    {
+        MaterialRecord record;
+        record.material = material;
+        record.program = static_cast<uint32_t>(programs.size());
+        for (size_t i = 0; i < programs.size(); i++)
+            if (programs[i] == material.shader)
+                record.program = static_cast<uint32_t>(i);
+        if (record.program == programs.size())
+        {
+            programs.push_back(material.shader);
+            programUniforms.push_back(ProgramUniforms());
+        }
+        materials.push_back(record);
+        MaterialHandle handle;
+        handle.index = static_cast<uint32_t>(materials.size()) - 1;
+        return handle;
+    }
+
+    // ʵıÿ֡޸ģһdraw()ʱϴ
+    PbrMaterialFactors& materialFactors(MaterialHandle material)
+    {
+        return materials[material.index].material.factors;
+    }
+
+    // עһȾģ +  + 任
+    RenderableHandle addRenderable(ModelHandle model, MaterialHandle material, const glm::mat4& transform = glm::mat4(1.0f))
+    {
+        RenderableRecord record;
+        record.model = model.index;
+        record.material = material.index;
+        record.visible = true;
+        record.removed = false;
+        renderables.push_back(record);
+        RenderableHandle handle;
+        handle.index = static_cast<uint32_t>(renderables.size()) - 1;
+        setTransform(handle, transform);
+        return handle;
+    }
+
+    void setTransform(RenderableHandle renderable, const glm::mat4& transform)
+    {
+        renderables[renderable.index].object.setTransform(transform);
+    }
+
+    // صĶύƶУѺϲMeshBatchеĸ
+    void setVisible(RenderableHandle renderable, bool visible)
+    {
+        RenderableRecord& record = renderables[renderable.index];
+        record.visible = visible && !record.removed;
+    }
+
+    // Ƴ󣺲ٻƣsetVisible()ҲָܻûδƳĶʹĲʱոòʵͼ
+    // עٳЩID֮ͷǣѸƵͼеĸͼȻЧ
+    void removeRenderable(RenderableHandle renderable)
+    {
+        RenderableRecord& record = renderables[renderable.index];
+        record.visible = false;
+        record.removed = true;
+        for (const RenderableRecord& other : renderables)
+            if (!other.removed && other.material == record.material)
+                return;
+        materials[record.material].material.maps = PbrMaterialMaps();
+    }
+
+    // ȫcameraPositionڼеȣͬһɽԶ
+    // ǰúFrameUniformsIBLɫObjectUniformsOBJECT_UNIFORM_BINDING
+    void draw(UniformRing& uniformRing, const glm::vec3& cameraPosition)
+    {
+        // ÿı任д뻷λһΣʱֻƫư
+        objectOffsets.resize(renderables.size());
+        queue.clear();
+        for (uint32_t i = 0; i < renderables.size(); i++)
+        {
+            const RenderableRecord& renderable = renderables[i];
+            if (!renderable.visible)
+                continue;
+            // λ屾֡ʱö󣬵ǰӦrenderableCount()UniformRing::reserve()Ԥ
+            objectOffsets[i] = uniformRing.write(renderable.object);
+            if (objectOffsets[i] == UniformRing::WRITE_FAILED)
+                continue;
+            float depth = glm::length(glm::vec3(renderable.object.model[3]) - cameraPosition);
+            const ModelRecord& model = models[renderable.model];
+            uint32_t program = materials[renderable.material].program;
+            for (uint32_t mesh = model.firstMesh; mesh < model.firstMesh + model.meshCount; mesh++)
+                queue.submit(makeSortKey(program, renderable.material, mesh, depth), i, mesh);
+        }
+        queue.sort();
+
+        stats = SceneDrawStats();
+        uint32_t currentProgram = UINT32_MAX;
+        uint32_t currentMaterial = UINT32_MAX;
+        uint32_t currentRenderable = UINT32_MAX;
+        for (const RenderQueue::Item& item : queue.items())
+        {
+            const RenderableRecord& renderable = renderables[item.renderable];
+            const MaterialRecord& material = materials[renderable.material];
+            if (material.program != currentProgram)
+            {
+                material.material.shader->use();
+                currentProgram = material.program;
+                stats.programChanges++;
+                // ڳһʹʱʱӳٱɫѾ
+                ProgramUniforms& uniforms = programUniforms[currentProgram];
+                if (!uniforms.resolved)
+                {
+                    uniforms.material = PbrMaterialUniforms(*material.material.shader);
+                    uniforms.resolved = true;
+                }
+            }
+            if (renderable.material != currentMaterial)
+            {
+                bindPbrMaterial(material.material.maps);
+                setPbrMaterialFactors(*material.material.shader, programUniforms[currentProgram].material, material.material.factors);
+                currentMaterial = renderable.material;
+                stats.materialChanges++;
+            }
+            if (item.renderable != currentRenderable)
+            {
+                uniformRing.bind(OBJECT_UNIFORM_BINDING, objectOffsets[item.renderable], sizeof(ObjectUniformData));
+                currentRenderable = item.renderable;
+            }
+            const MeshDraw& mesh = meshes[item.mesh];
+            GLStateCache::instance().bindVertexArray(mesh.vao);
+            glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+            stats.draws++;
+        }
+    }
+
+    size_t renderableCount() const
+    {
+        return renderables.size();
+    }
+
+    // һdraw()ͳ
+    const SceneDrawStats& drawStats() const
+    {
+        return stats;
+    }
+
+private:
+    struct MeshDraw {
+        unsigned int vao;
+        GLsizei indexCount;
+    };
+    // ģmeshesе
+    struct ModelRecord {
+        uint32_t firstMesh;
+        uint32_t meshCount;
+    };
+    struct MaterialRecord {
+        Material material;
+        uint32_t program;     // programsе±
+    };
+    struct ProgramUniforms {
+        PbrMaterialUniforms material;
+        bool resolved = false;
+    };
+    struct RenderableRecord {
+        uint32_t model;
+        uint32_t material;
+        bool visible;
+        bool removed;         // removeRenderable()Ƴ
+        ObjectUniformData object;
+    };
+
+    std::vector<MeshDraw> meshes;
+    std::vector<ModelRecord> models;
+    std::vector<Shader*> programs;
+    std::vector<ProgramUniforms> programUniforms;   // programsӦ
+    std::vector<MaterialRecord> materials;
+    std::vector<RenderableRecord> renderables;
+    RenderQueue queue;
+    std::vector<GLintptr> objectOffsets;
+    SceneDrawStats stats;
+};
+#endif
@@ -4,10 +4,23 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <gl_state_cache.h>
+#include <parallel_shader_compile.h>
+#include <program_binary.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// ԤȽuniformֻλãͲShader::setʹĸglUniform*
+// λΪ-1uniformڻ򱻱ŻʱЧglGetUniformLocationһ
+template<class T>
+struct UniformHandle {
+    GLint location = -1;
+};
 
 // ######################################
 // # Class Shader
@@ -16,8 +29,13 @@ class Shader
 {
 public:
     unsigned int ID;
-    // 캯̬ɫ
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    // 캯̬ɫdefines"#define USE_ORM_MAP\n"뵽ÿ׶ε#version֮ڱͬһԴĲͬ塣
+    // ֳ֧ʱprogram_binary.hȴӻӺõĳδʱ벢д뻺档
+    // deferredΪtrueʱֻύӣȴڵһuse()ʱ飺ȴȫɫʹã
+    // ֧KHR_parallel_shader_compileԼ߳ͬʱǣparallel_shader_compile.h
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::string& defines = std::string(),
+           bool deferred = false)
+        : pending(false), vertex(0), fragment(0), geometry(0), binaryKey(0)
     {
         // 1. ļ·м/ƬԴ
         std::string vertexCode;
@@ -43,8 +61,8 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // תΪַ
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
+            vertexCode = addDefines(vShaderStream.str(), defines);
+            fragmentCode = addDefines(fShaderStream.str(), defines);
             // ṩ˼ɫ·򻹼һɫ
             if(geometryPath != nullptr)
             {
@@ -52,7 +70,7 @@ public:
                 std::stringstream gShaderStream;
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                geometryCode = addDefines(gShaderStream.str(), defines);
             }
         }
         catch (std::ifstream::failure& e)
@@ -60,29 +78,36 @@ public:
             // ȡʧܣӡϢ
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        // Դûб仯ʱֱӼػĳ
+        if (glProgramBinaries().supported)
+        {
+            binaryPath = programBinaryPath(vertexPath, fragmentPath, geometryPath, defines);
+            binaryKey = programBinaryKey({ vertexCode, fragmentCode, geometryCode });
+            ID = loadProgramBinary(binaryPath, binaryKey);
+            if (ID != 0)
+            {
+                reflectUniforms();
+                return;
+            }
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. ɫ
-        unsigned int vertex, fragment;
+        // 2. ύ룬resolve()м
         // ɫ
         vertex = glCreateShader(GL_VERTEX_SHADER);
         glShaderSource(vertex, 1, &vShaderCode, NULL);
         glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
         // Ƭɫ
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
         glShaderSource(fragment, 1, &fShaderCode, NULL);
         glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
         // ṩ˼ɫ뼸ɫ
-        unsigned int geometry;
         if(geometryPath != nullptr)
         {
             const char * gShaderCode = geometryCode.c_str();
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometry, 1, &gShaderCode, NULL);
             glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
         }
         // ɫ
         ID = glCreateProgram();
@@ -90,81 +115,237 @@ public:
         glAttachShader(ID, fragment);
         if(geometryPath != nullptr)
             glAttachShader(ID, geometry);
+        markProgramBinaryRetrievable(ID);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        pending = true;
+        if (!deferred)
+            resolve();
+    }
+    // ɫӳٴɫһʹʱȴɲ
+    void use() 
+    { 
+        if (pending)
+            resolve();
+        GLStateCache::instance().useProgram(ID); 
+    }
+    // ǷѾɣֲ֧бʱǷtrueʱuse()ͬ
+    bool ready() const
+    {
+        if (!pending || !glParallelShaderCompile().supported)
+            return true;
+        GLint completed = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+        return completed == GL_TRUE;
+    }
+    // ں̨߳ɱʱresolve()true
+    // ֲ֧бʱ飬falseһʹʱͬ
+    bool resolveIfReady()
+    {
+        if (!pending)
+            return true;
+        if (!glParallelShaderCompile().supported || !ready())
+            return false;
+        resolve();
+        return true;
+    }
+    // ȴɣ󣬳ɹʱдƻ棬Ȼɾɫ
+    void resolve()
+    {
+        if (!pending)
+            return;
+        pending = false;
+        checkCompileErrors(vertex, "VERTEX");
+        checkCompileErrors(fragment, "FRAGMENT");
+        if (geometry != 0)
+            checkCompileErrors(geometry, "GEOMETRY");
+        if (checkCompileErrors(ID, "PROGRAM") && !binaryPath.empty())
+            saveProgramBinary(binaryPath, binaryKey, ID);
+        reflectUniforms();
         // ɾɫΪӵǵĳУҪ
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-        if(geometryPath != nullptr)
+        if (geometry != 0)
             glDeleteShader(geometry);
-
+        vertex = fragment = geometry = 0;
     }
-    // ɫ
-    void use() 
-    { 
-        glUseProgram(ID); 
+    // uniformλãʱıвңglGetUniformLocationĸԪأ"name[i]"Բ
+    GLint uniformLocation(const std::string &name) const
+    {
+        std::unordered_map<std::string, GLint>::const_iterator it = uniforms.find(name);
+        return it != uniforms.end() ? it->second : -1;
+    }
+    // һuniformڳʼʱһΣ֮Ⱦѭͨset()ãٹַͲ
+    template<class T>
+    UniformHandle<T> uniform(const std::string &name)
+    {
+        resolve();
+        UniformHandle<T> handle;
+        handle.location = uniformLocation(name);
+        return handle;
+    }
+    // ɫΪnameuniform󶨵bindinguniform_buffer.hɫûиÿʱԡ
+    // ӣسƣùÿδ
+    void bindUniformBlock(const std::string &name, GLuint binding)
+    {
+        resolve();
+        GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+    // ͨuniform
+    void set(UniformHandle<int> handle, int value) const
+    {
+        glUniform1i(handle.location, value);
+    }
+    void set(UniformHandle<float> handle, float value) const
+    {
+        glUniform1f(handle.location, value);
+    }
+    void set(UniformHandle<glm::vec2> handle, const glm::vec2 &value) const
+    {
+        glUniform2fv(handle.location, 1, &value[0]);
+    }
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const
+    {
+        glUniform3fv(handle.location, 1, &value[0]);
+    }
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const
+    {
+        glUniform4fv(handle.location, 1, &value[0]);
+    }
+    void set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // ӾָԪؿʼһcountvec3Ԫ
+    void set(UniformHandle<glm::vec3> handle, const float *values, GLsizei count) const
+    {
+        glUniform3fv(handle.location, count, values);
     }
     // ߺuniform
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(uniformLocation(name), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(uniformLocation(name), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(uniformLocation(name), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(uniformLocation(name), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(uniformLocation(name), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(uniformLocation(name), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(uniformLocation(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(uniformLocation(name), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(uniformLocation(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(uniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(uniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // ɫ/Ӵ
-    void checkCompileErrors(GLuint shader, std::string type)
+    // ύδı
+    bool pending;
+    unsigned int vertex;
+    unsigned int fragment;
+    unsigned int geometry;
+    std::string binaryPath;
+    uint64_t binaryKey;
+    // Ӻõȫuniformλ
+    std::unordered_map<std::string, GLint> uniforms;
+
+    // ѯȫuniform¼λáֻ"name[0]"ͬʱ¼Ԫ
+    void reflectUniforms()
+    {
+        uniforms.clear();
+        GLint count = 0;
+        GLint maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), length);
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            // uniformеĳԱûλ
+            if (location < 0)
+                continue;
+            uniforms[name] = location;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                uniforms[base] = location;
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniforms[elementName] = glGetUniformLocation(ID, elementName.c_str());
+                }
+            }
+        }
+    }
+
+    // #version֮궨
+    static std::string addDefines(const std::string& code, const std::string& defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t insertAt = 0;
+        size_t version = code.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = code.find('\n', version);
+            insertAt = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        }
+        return code.substr(0, insertAt) + defines + code.substr(insertAt);
+    }
+
+    // ɫ/Ӵ󣬳ɹʱtrue
+    bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -186,6 +367,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success != 0;
     }
 };
 #endif
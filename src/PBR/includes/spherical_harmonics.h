@@ -0,0 +1,160 @@
+#ifndef SPHERICAL_HARMONICS_H
+#define SPHERICAL_HARMONICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPHERICAL_HARMONICS_SSE 1
+#include <emmintrin.h>
+#endif
+
+// L2г9ϵʾնȣѻͼһԱͶӰгϣ
+// ҲRamamoorthi & Hanrahan, "An Efficient Representation for Irradiance Environment Maps"
+// ϵѳϻĹһϵ1/PIԭնͼȡֵE / PIһ£
+// pbr.fsֻ
+//   c0 + c1 y + c2 z + c3 x + c4 xy + c5 yz + c6 (3z^2 - 1) + c7 xz + c8 (x^2 - y^2)
+// GLʱߺ決
+
+// նȵгϵÿϵΪRGB
+struct IrradianceSH {
+    float coefficients[9][3];
+};
+
+// ͼface(sc, tc)[-1, 1]ɳӦķ򣬰GL淶еԼ
+inline void cubeTexelDirection(int face, float sc, float tc, float direction[3])
+{
+    switch (face)
+    {
+    case 0: direction[0] = 1.0f; direction[1] = -tc; direction[2] = -sc; break;
+    case 1: direction[0] = -1.0f; direction[1] = -tc; direction[2] = sc; break;
+    case 2: direction[0] = sc; direction[1] = 1.0f; direction[2] = tc; break;
+    case 3: direction[0] = sc; direction[1] = -1.0f; direction[2] = -tc; break;
+    case 4: direction[0] = sc; direction[1] = -tc; direction[2] = 1.0f; break;
+    default: direction[0] = -sc; direction[1] = -tc; direction[2] = -1.0f; break;
+    }
+}
+
+// ͶӰۼӺͣÿΪ L * polynomial * dw / (2 / size)^2sizeΪͶӰͼÿߴ磩õնгϵ
+// ͶӰϵL_lm = sum(L * Y_lm * dw)Y_lm = basis * polynomialֵʱҪٳһbasis
+inline IrradianceSH irradianceSHFromSums(const double sums[9][3], int size)
+{
+    // Ĺһ˳Ķʽһ
+    const float basis[9] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+    // ҲϵA_l / PIl = 0Ϊ1l = 1Ϊ2/3l = 2Ϊ1/4
+    const float band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    IrradianceSH sh;
+    double texelScale = 2.0 / size;
+    double texelArea = texelScale * texelScale;
+    for (int i = 0; i < 9; i++)
+        for (int c = 0; c < 3; c++)
+            sh.coefficients[i][c] = static_cast<float>(sums[i][c] * texelArea * basis[i] * basis[i] * band[i]);
+    return sh;
+}
+
+// 6RGBݣÿsize x sizeȣͶӰΪնгϵ
+// ÿصΪ(2 / size)^2 / (1 + sc^2 + tc^2)^(3/2)simdΪtrueʱһδһе4
+inline IrradianceSH projectIrradianceSH(const float* const faces[6], int size, bool simd = true)
+{
+    double sums[9][3];
+    memset(sums, 0, sizeof(sums));
+    float texelScale = 2.0f / size;
+
+    for (int face = 0; face < 6; face++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            const float* row = faces[face] + (size_t)y * size * 3;
+            float tc = (y + 0.5f) * texelScale - 1.0f;
+            float rowSums[9][3];
+            memset(rowSums, 0, sizeof(rowSums));
+            int x = 0;
+#ifdef SPHERICAL_HARMONICS_SSE
+            if (simd)
+            {
+                // һֻsc仯ԼԵģд d = origin + sc * sDirection
+                float origin[3], sDirection[3];
+                cubeTexelDirection(face, 0.0f, tc, origin);
+                cubeTexelDirection(face, 1.0f, tc, sDirection);
+                for (int c = 0; c < 3; c++)
+                    sDirection[c] -= origin[c];
+                __m128 accumulated[9][3];
+                for (int i = 0; i < 9; i++)
+                    for (int c = 0; c < 3; c++)
+                        accumulated[i][c] = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 three = _mm_set1_ps(3.0f);
+                const __m128 tc2 = _mm_set1_ps(tc * tc);
+                for (; x + 4 <= size; x += 4)
+                {
+                    __m128 sc = _mm_sub_ps(_mm_mul_ps(_mm_set_ps(x + 3.5f, x + 2.5f, x + 1.5f, x + 0.5f), _mm_set1_ps(texelScale)), one);
+                    __m128 dx = _mm_add_ps(_mm_set1_ps(origin[0]), _mm_mul_ps(sc, _mm_set1_ps(sDirection[0])));
+                    __m128 dy = _mm_add_ps(_mm_set1_ps(origin[1]), _mm_mul_ps(sc, _mm_set1_ps(sDirection[1])));
+                    __m128 dz = _mm_add_ps(_mm_set1_ps(origin[2]), _mm_mul_ps(sc, _mm_set1_ps(sDirection[2])));
+                    // |d|^2 = 1 + sc^2 + tc^2 = 1 / |d|^3(2 / size)^2ͳһϣ
+                    __m128 lengthSquared = _mm_add_ps(_mm_add_ps(one, tc2), _mm_mul_ps(sc, sc));
+                    __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+                    __m128 solidAngle = _mm_mul_ps(inverseLength, _mm_mul_ps(inverseLength, inverseLength));
+                    dx = _mm_mul_ps(dx, inverseLength);
+                    dy = _mm_mul_ps(dy, inverseLength);
+                    dz = _mm_mul_ps(dz, inverseLength);
+                    __m128 polynomial[9] = { one, dy, dz, dx, _mm_mul_ps(dx, dy), _mm_mul_ps(dy, dz), _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(dz, dz)), one),
+                                             _mm_mul_ps(dx, dz), _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)) };
+                    const float* texel = row + (size_t)x * 3;
+                    __m128 color[3];
+                    for (int c = 0; c < 3; c++)
+                        color[c] = _mm_mul_ps(solidAngle, _mm_set_ps(texel[9 + c], texel[6 + c], texel[3 + c], texel[c]));
+                    for (int i = 0; i < 9; i++)
+                        for (int c = 0; c < 3; c++)
+                            accumulated[i][c] = _mm_add_ps(accumulated[i][c], _mm_mul_ps(polynomial[i], color[c]));
+                }
+                for (int i = 0; i < 9; i++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        alignas(16) float lanes[4];
+                        _mm_store_ps(lanes, accumulated[i][c]);
+                        rowSums[i][c] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+                    }
+                }
+            }
+#endif
+            (void)simd;
+            for (; x < size; x++)
+            {
+                float sc = (x + 0.5f) * texelScale - 1.0f;
+                float d[3];
+                cubeTexelDirection(face, sc, tc, d);
+                float inverseLength = 1.0f / std::sqrt(1.0f + sc * sc + tc * tc);
+                float solidAngle = inverseLength * inverseLength * inverseLength;
+                float dx = d[0] * inverseLength, dy = d[1] * inverseLength, dz = d[2] * inverseLength;
+                float polynomial[9] = { 1.0f, dy, dz, dx, dx * dy, dy * dz, 3.0f * dz * dz - 1.0f, dx * dz, dx * dx - dy * dy };
+                const float* texel = row + (size_t)x * 3;
+                for (int i = 0; i < 9; i++)
+                    for (int c = 0; c < 3; c++)
+                        rowSums[i][c] += polynomial[i] * solidAngle * texel[c];
+            }
+            for (int i = 0; i < 9; i++)
+                for (int c = 0; c < 3; c++)
+                    sums[i][c] += rowSums[i][c];
+        }
+    }
+
+    return irradianceSHFromSums(sums, size);
+}
+
+// ڹһnֵpbr.fsеirradianceFromSHͬ
+inline void evaluateIrradianceSH(const IrradianceSH& sh, const float n[3], float result[3])
+{
+    float x = n[0], y = n[1], z = n[2];
+    float polynomial[9] = { 1.0f, y, z, x, x * y, y * z, 3.0f * z * z - 1.0f, x * z, x * x - y * y };
+    for (int c = 0; c < 3; c++)
+    {
+        float value = 0.0f;
+        for (int i = 0; i < 9; i++)
+            value += sh.coefficients[i][c] * polynomial[i];
+        result[c] = std::max(value, 0.0f);
+    }
+}
+#endif
@@ -0,0 +1,174 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <content_hash.h>
+#include <cooked_texture.h>
+#include <file_system.h>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ######################################
+// # Class TextureCache
+// ######################################
+// ڹ棺Ȱ淶·ңδʱٰļݲң
+// ͬ·ͬͼҲֻϴһΡݲȱȽļСֻļԣ
+// ֻдСͬĺѡӳļϣÿļĹϣڵһҪʱһΣ
+// СͬGL߳ϲȡļݡGLüһrelease()ʱɾ
+// ֻGL߳ʹãʱGLĿ٣
+class TextureCache
+{
+public:
+    // ĻصΪ·IDԺݵռλʧʱ0
+    typedef std::function<unsigned int(const std::string&)> Loader;
+
+    TextureCache() : pathHits(0), contentHits(0), misses(0)
+    {
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // ȫʵ
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // ȡpathӦüûʱload
+    unsigned int acquire(const std::string& path, bool flipVertically, const Loader& load)
+    {
+        std::string pathKey = canonicalPath(path) + (flipVertically ? "|flip" : "");
+        auto byPath = pathIndex.find(pathKey);
+        if (byPath != pathIndex.end())
+        {
+            entries[byPath->second].refCount++;
+            pathHits++;
+            return byPath->second;
+        }
+
+        // ݲңʹԴͼֻк決ļʱʹú決ļ
+        std::string contentPath = path;
+        uint64_t size = fileSize(contentPath);
+        if (size == 0)
+        {
+            contentPath = cookedTexturePath(path);
+            size = fileSize(contentPath);
+        }
+        uint64_t sizeKey = sizeIndexKey(size, flipVertically);
+        if (size != 0)
+        {
+            bool hashed = false;
+            uint64_t hash = 0;
+            auto candidates = sizeIndex.equal_range(sizeKey);
+            for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+            {
+                Entry& entry = entries[candidate->second];
+                if (entry.contentSize != size || entry.flipVertically != flipVertically)
+                    continue;
+                // СͬҪȽݣߵĹϣֻһ
+                if (!hashed && !(hashed = hashFileContents(contentPath, hash)))
+                    break;
+                if (!entry.hashed && !(entry.hashed = hashFileContents(entry.contentPath, entry.contentHash)))
+                    continue;
+                if (entry.contentHash == hash)
+                {
+                    entry.refCount++;
+                    entry.pathKeys.push_back(pathKey);
+                    pathIndex[pathKey] = candidate->second;
+                    contentHits++;
+                    return candidate->second;
+                }
+            }
+        }
+
+        unsigned int textureID = load(path);
+        if (textureID == 0)
+            return 0;
+        misses++;
+        Entry& entry = entries[textureID];
+        entry.refCount = 1;
+        entry.pathKeys.assign(1, pathKey);
+        entry.contentPath = contentPath;
+        entry.hashed = false;
+        entry.contentHash = 0;
+        entry.contentSize = size;
+        entry.flipVertically = flipVertically;
+        pathIndex[pathKey] = textureID;
+        if (size != 0)
+            sizeIndex.emplace(sizeKey, textureID);
+        return textureID;
+    }
+
+    // һѻȡ
+    void retain(unsigned int textureID)
+    {
+        auto found = entries.find(textureID);
+        if (found != entries.end())
+            found->second.refCount++;
+    }
+
+    // ü0ʱɾGLƳ
+    void release(unsigned int textureID)
+    {
+        auto found = entries.find(textureID);
+        if (found == entries.end() || --found->second.refCount > 0)
+            return;
+        for (size_t i = 0; i < found->second.pathKeys.size(); i++)
+            pathIndex.erase(found->second.pathKeys[i]);
+        auto candidates = sizeIndex.equal_range(sizeIndexKey(found->second.contentSize, found->second.flipVertically));
+        for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+        {
+            if (candidate->second == textureID)
+            {
+                sizeIndex.erase(candidate);
+                break;
+            }
+        }
+        entries.erase(found);
+        glDeleteTextures(1, &textureID);
+    }
+
+    // 
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    void printStats() const
+    {
+        std::cout << "TextureCache: " << entries.size() << " textures, " << misses << " loaded, "
+                  << pathHits << " path hits, " << contentHits << " content hits" << std::endl;
+    }
+
+private:
+    struct Entry {
+        unsigned int refCount;
+        std::vector<std::string> pathKeys;  // ָȫ·
+        std::string contentPath;            // ȽʱȡļԴͼ決ļ
+        bool hashed;                        // contentHashǷѼ
+        uint64_t contentHash;
+        uint64_t contentSize;               // Ϊ0ʱļڣݲ
+        bool flipVertically;
+    };
+
+    std::unordered_map<unsigned int, Entry> entries;
+    std::unordered_map<std::string, unsigned int> pathIndex;
+    std::unordered_multimap<uint64_t, unsigned int> sizeIndex;  // (ļС, ת) -> 
+    unsigned int pathHits;
+    unsigned int contentHits;
+    unsigned int misses;
+
+    static uint64_t sizeIndexKey(uint64_t size, bool flipVertically)
+    {
+        return (size << 1) | (flipVertically ? 1ull : 0ull);
+    }
+};
+#endif
@@ -0,0 +1,288 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <cooked_texture.h>
+#include <gl_extensions.h>
+#include <image.h>
+#include <mapped_file.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 3.3ģʽgladûS3TC/BPTCչö
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// 決ʽӦGLڲʽѹʽ0
+inline GLenum compressedInternalFormat(uint32_t format)
+{
+    switch (format)
+    {
+    case COOKED_FORMAT_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case COOKED_FORMAT_BC4: return GL_COMPRESSED_RED_RGTC1;
+    case COOKED_FORMAT_BC5: return GL_COMPRESSED_RG_RGTC2;
+    case COOKED_FORMAT_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return 0;
+    }
+}
+
+// ǰֱܷʹøú決RGTCBC4/BC53.0ĹܣBC1ҪS3TCչBC7Ҫ4.2BPTCչ
+// ֧ʱӦ˻صԴͼ
+inline bool cookedTextureSupported(const CookedTextureView& cooked)
+{
+    if (!cooked.header)
+        return false;
+    static const bool s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    static const bool bptc = hasGLExtension("GL_ARB_texture_compression_bptc") || hasGLVersion(4, 2);
+    switch (cooked.header->format)
+    {
+    case COOKED_FORMAT_BC1: return s3tc;
+    case COOKED_FORMAT_BC7: return bptc;
+    default: return true;
+    }
+}
+
+// ÿطӦظʽ
+inline GLenum textureFormat(int nrComponents)
+{
+    if (nrComponents == 1)
+        return GL_RED;
+    else if (nrComponents == 4)
+        return GL_RGBA;
+    return GL_RGB;
+}
+
+// ͼϴ󣬲mipmap
+inline bool uploadTexture2D(unsigned int textureID, const ImageData& image)
+{
+    if (!image.data)
+        return false;
+
+    GLenum format = textureFormat(image.nrComponents);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return true;
+}
+
+// Ѻ決õmipֱӴӳڴϴglGenerateMipmapBCʽglCompressedTexImage2Dϴ
+inline bool uploadCookedTexture2D(unsigned int textureID, const CookedTextureView& cooked)
+{
+    if (!cookedTextureSupported(cooked))
+        return false;
+
+    GLenum format = textureFormat(cooked.header->nrComponents);
+    GLenum internalFormat = compressedInternalFormat(cooked.header->format);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t level = 0; level < cooked.header->levelCount; level++)
+    {
+        const CookedTextureLevel& info = cooked.levels[level];
+        if (internalFormat)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, info.width, info.height, 0, static_cast<GLsizei>(info.size), cooked.levelData(level));
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, format, info.width, info.height, 0, format, GL_UNSIGNED_BYTE, cooked.levelData(level));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.header->levelCount - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return true;
+}
+
+// ʹú決ļpath.ctexûпõĺ決ļʱԴͼ
+inline bool loadTexture2D(unsigned int textureID, const std::string& path, bool flipVertically = false)
+{
+    MappedFile cookedFile;
+    CookedTextureView cooked;
+    if (openCookedTexture(path, flipVertically, cookedFile, cooked) && uploadCookedTexture2D(textureID, cooked))
+        return true;
+
+    ImageData image = decodeImage(path, flipVertically);
+    bool loaded = uploadTexture2D(textureID, image);
+    freeImage(image);
+    return loaded;
+}
+
+// ######################################
+// # Class TextureBatch
+// ######################################
+// ͼ̳߳вн룬GLϴֻڵfinish()߳аύ˳
+class TextureBatch
+{
+public:
+    TextureBatch(ThreadPool& pool) : pool(pool), submitted(false)
+    {
+    }
+
+    // ύһIDfinish()֮Ч
+    unsigned int add(const std::string& path, bool flipVertically = false)
+    {
+        if (!submitted)
+        {
+            batchStart = std::chrono::high_resolution_clock::now();
+            lastDecodeEnd = batchStart;
+            submitted = true;
+        }
+
+        PendingTexture pending;
+        glGenTextures(1, &pending.textureID);
+        pending.path = path;
+        pending.flipVertically = flipVertically;
+
+        // к決ļʱֻӳ䣬finish()ֱӴӳڴϴҪ
+        pending.cookedFile = std::make_shared<MappedFile>();
+        if (openCookedTexture(path, flipVertically, *pending.cookedFile, pending.cooked) && cookedTextureSupported(pending.cooked))
+        {
+            pendingTextures.push_back(std::move(pending));
+            return pendingTextures.back().textureID;
+        }
+        pending.cookedFile.reset();
+        pending.image = pool.enqueue([this, path, flipVertically] {
+            ImageData image = decodeImage(path, flipVertically);
+            std::lock_guard<std::mutex> lock(timingMutex);
+            lastDecodeEnd = std::max(lastDecodeEnd, std::chrono::high_resolution_clock::now());
+            return image;
+        });
+        pendingTextures.push_back(std::move(pending));
+        return pendingTextures.back().textureID;
+    }
+
+    // ύ˳ȴϴʱͳ
+    void finish()
+    {
+        double decodeSumMs = 0.0;
+        double uploadMs = 0.0;
+        size_t decodedBytes = 0;
+        size_t cookedBytes = 0;
+        unsigned int cookedCount = 0;
+        for (unsigned int i = 0; i < pendingTextures.size(); i++)
+        {
+            if (pendingTextures[i].cookedFile)
+            {
+                std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+                if (uploadCookedTexture2D(pendingTextures[i].textureID, pendingTextures[i].cooked))
+                {
+                    cookedBytes += pendingTextures[i].cookedFile->size();
+                    cookedCount++;
+                }
+                else
+                    std::cout << "Texture failed to load at path: " << pendingTextures[i].path << std::endl;
+                uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+                pendingTextures[i].cookedFile.reset();
+                continue;
+            }
+
+            ImageData image = pendingTextures[i].image.get();
+            decodeSumMs += image.decodeMs;
+
+            std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+            if (uploadTexture2D(pendingTextures[i].textureID, image))
+                decodedBytes += (size_t)image.width * image.height * image.nrComponents;
+            else
+                std::cout << "Texture failed to load at path: " << pendingTextures[i].path << std::endl;
+            uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+
+            freeImage(image);
+        }
+
+        double decodeWallMs = std::chrono::duration<double, std::milli>(lastDecodeEnd - batchStart).count();
+        std::cout << "TextureBatch: " << pendingTextures.size() << " textures (" << cookedCount << " cooked, "
+                  << cookedBytes / (1024 * 1024) << " MB mapped), " << decodedBytes / (1024 * 1024) << " MB decoded, "
+                  << pool.size() << " threads | decode wall " << std::fixed << std::setprecision(1) << decodeWallMs
+                  << " ms (sum " << decodeSumMs << " ms) | upload " << uploadMs << " ms" << std::defaultfloat << std::endl;
+
+        for (unsigned int i = 0; i < pendingTextures.size(); i++)
+            requests.push_back(Request{ pendingTextures[i].path, pendingTextures[i].flipVertically });
+        pendingTextures.clear();
+        submitted = false;
+    }
+
+    // 1, 2, 4 ... ߳ظѼعȫͼǽʱ߳ı仯
+    void benchmark(unsigned int maxThreads = 0) const
+    {
+        if (maxThreads == 0)
+            maxThreads = ThreadPool::defaultThreadCount();
+
+        std::cout << "TextureBatch decode benchmark (" << requests.size() << " images)" << std::endl;
+        double singleThreadMs = 0.0;
+        for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            {
+                ThreadPool benchPool(threads);
+                std::vector<std::future<ImageData>> images;
+                for (unsigned int i = 0; i < requests.size(); i++)
+                {
+                    Request request = requests[i];
+                    images.push_back(benchPool.enqueue([request] { return decodeImage(request.path, request.flipVertically); }));
+                }
+                for (unsigned int i = 0; i < images.size(); i++)
+                {
+                    ImageData image = images[i].get();
+                    freeImage(image);
+                }
+            }
+            double wallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (threads == 1)
+                singleThreadMs = wallMs;
+
+            std::cout << "  threads " << std::setw(3) << threads << " | decode wall " << std::fixed << std::setprecision(1)
+                      << std::setw(9) << wallMs << " ms | speedup " << std::setprecision(2) << singleThreadMs / wallMs
+                      << "x" << std::defaultfloat << std::endl;
+
+            if (threads == maxThreads)
+                break;
+        }
+    }
+
+private:
+    struct PendingTexture {
+        unsigned int textureID;
+        std::string path;
+        bool flipVertically;
+        std::future<ImageData> image;
+        // ʹú決ļʱЧʱimageЧ
+        std::shared_ptr<MappedFile> cookedFile;
+        CookedTextureView cooked;
+    };
+    struct Request {
+        std::string path;
+        bool flipVertically;
+    };
+
+    ThreadPool& pool;
+    std::vector<PendingTexture> pendingTextures;
+    // ɼص󣬹benchmark()ط
+    std::vector<Request> requests;
+
+    bool submitted;
+    std::mutex timingMutex;
+    std::chrono::high_resolution_clock::time_point batchStart;
+    std::chrono::high_resolution_clock::time_point lastDecodeEnd;
+};
+#endif
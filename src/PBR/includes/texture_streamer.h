@@ -0,0 +1,382 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cooked_texture.h>
+#include <image.h>
+#include <mapped_file.h>
+#include <texture_loader.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ######################################
+// # Class TextureStreamer
+// ######################################
+// 첽ʽأrequest()һָ1x1ռλID
+// ͼ̳߳н룬֮ÿ֡update()ͨPBOλ尴ֽԤϴ
+// ȫϴɺmipmapлΪʵIDֲ䣩
+// к決ļ.ctexʱ룬ӳڴСϴÿһһ
+// ʧʱȥռλͼͬʧʱһûд洢Ϊ0
+class TextureStreamer
+{
+public:
+    // uploadBudgetÿ֡ϴֽpboCount/pboSizePBOÿPBOĴС
+    TextureStreamer(ThreadPool& pool, size_t uploadBudget = 16 * 1024 * 1024, unsigned int pboCount = 3, size_t pboSize = 4 * 1024 * 1024)
+        : pool(pool), uploadBudget(uploadBudget), pboSize(pboSize), nextPbo(0), uploadedBytes(0)
+    {
+        pbos.resize(pboCount);
+        for (unsigned int i = 0; i < pboCount; i++)
+        {
+            glGenBuffers(1, &pbos[i].buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i].buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, pboSize, nullptr, GL_STREAM_DRAW);
+            pbos[i].fence = 0;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // ȴڽͷͼڴ棨GLһ٣
+    ~TextureStreamer()
+    {
+        for (unsigned int i = 0; i < jobs.size(); i++)
+        {
+            if (jobs[i].future.valid())
+                jobs[i].image = jobs[i].future.get();
+            freeImage(jobs[i].image);
+        }
+    }
+
+    // һIDʱΪplaceholderɫ
+    unsigned int request(const std::string& path, bool flipVertically = false, const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f))
+    {
+        StreamJob job;
+        glGenTextures(1, &job.textureID);
+        job.path = path;
+        job.placeholder = placeholder;
+        job.level = 0;
+        job.levelWidth = 0;
+        job.levelHeight = 0;
+        job.levelPixels = nullptr;
+        job.levelRows = 0;
+        job.rowSize = 0;
+        job.internalFormat = 0;
+        job.rowsUploaded = 0;
+        job.started = false;
+        job.requestTime = std::chrono::high_resolution_clock::now();
+
+        // 1x1ռλ
+        unsigned char texel[4];
+        placeholderTexel(placeholder, texel);
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        job.cookedFile = std::make_shared<MappedFile>();
+        if (!openCookedTexture(path, flipVertically, *job.cookedFile, job.cooked) || !cookedTextureSupported(job.cooked))
+        {
+            job.cookedFile.reset();
+            job.future = pool.enqueue([path, flipVertically] { return decodeImage(path, flipVertically); });
+        }
+        jobs.push_back(std::move(job));
+        return jobs.back().textureID;
+    }
+
+    // ÿ֡GL̵߳һΣɵPBOԤڼϴ
+    void update()
+    {
+        size_t budget = uploadBudget;
+        for (size_t i = 0; i < jobs.size(); )
+        {
+            StreamJob& job = jobs[i];
+            if (!job.started && job.cookedFile)
+                beginCookedStreaming(job);
+            else if (!job.started)
+            {
+                // δʱȴѾõ
+                if (job.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    i++;
+                    continue;
+                }
+                job.image = job.future.get();
+                if (!job.image.data)
+                {
+                    std::cout << "Texture failed to load at path: " << job.path << std::endl;
+                    glBindTexture(GL_TEXTURE_2D, job.textureID);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                    jobs.erase(jobs.begin() + i);
+                    continue;
+                }
+                beginStreaming(job);
+            }
+
+            // ԤľPBOʹУʣಿһ֡
+            if (!uploadLevels(job, budget))
+                break;
+
+            finishStreaming(job);
+            jobs.erase(jobs.begin() + i);
+        }
+    }
+
+    // Ƿδɵ
+    bool idle() const
+    {
+        return jobs.empty();
+    }
+
+    // δɵ
+    size_t pendingCount() const
+    {
+        return jobs.size();
+    }
+
+    // ۼͨPBOϴֽ
+    size_t totalUploadedBytes() const
+    {
+        return uploadedBytes;
+    }
+
+private:
+    struct StreamJob {
+        unsigned int textureID;
+        std::string path;
+        glm::vec4 placeholder;
+        std::future<ImageData> future;
+        ImageData image;
+        // ʹú決ļʱЧʱҪ
+        std::shared_ptr<MappedFile> cookedFile;
+        CookedTextureView cooked;
+        GLenum format;
+        // BCʽGLڲʽѹʱΪ0
+        GLenum internalFormat;
+        // ϴmipѹʽһСһ4x4
+        int level;
+        int levelWidth;
+        int levelHeight;
+        const unsigned char* levelPixels;
+        int levelRows;
+        size_t rowSize;
+        int rowsUploaded;
+        bool started;
+        std::chrono::high_resolution_clock::time_point requestTime;
+    };
+    struct PixelBuffer {
+        unsigned int buffer;
+        GLsync fence;
+    };
+
+    ThreadPool& pool;
+    std::deque<StreamJob> jobs;
+    std::vector<PixelBuffer> pbos;
+    size_t uploadBudget;
+    size_t pboSize;
+    unsigned int nextPbo;
+    size_t uploadedBytes;
+
+    static void placeholderTexel(const glm::vec4& color, unsigned char* texel)
+    {
+        for (int i = 0; i < 4; i++)
+            texel[i] = static_cast<unsigned char>(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    // ߴ0洢ռλɫСmipϡ
+    // ϴڼ佫BASE_LEVEL/MAX_LEVELָü𣬲ֻռλɫῴδд0
+    void beginStreaming(StreamJob& job)
+    {
+        job.started = true;
+        job.format = textureFormat(job.image.nrComponents);
+        job.level = 0;
+        job.levelWidth = job.image.width;
+        job.levelHeight = job.image.height;
+        job.levelPixels = job.image.data;
+        job.levelRows = job.image.height;
+        job.rowSize = (size_t)job.image.width * job.image.nrComponents;
+        job.internalFormat = 0;
+
+        int lastLevel = 0;
+        while ((std::max(job.image.width, job.image.height) >> lastLevel) > 1)
+            lastLevel++;
+        int lastWidth = std::max(1, job.image.width >> lastLevel);
+        int lastHeight = std::max(1, job.image.height >> lastLevel);
+
+        unsigned char texel[4];
+        placeholderTexel(job.placeholder, texel);
+        std::vector<unsigned char> lastLevelData((size_t)lastWidth * lastHeight * 4);
+        for (size_t i = 0; i < lastLevelData.size(); i += 4)
+            memcpy(&lastLevelData[i], texel, 4);
+
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, job.format, job.image.width, job.image.height, 0, job.format, GL_UNSIGNED_BYTE, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, lastLevel, job.format, lastWidth, lastHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, lastLevelData.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+    }
+
+    // Ϊȫ洢СļֱӴӳڴϴ֮ӵڶʼ0ʽϴ
+    void beginCookedStreaming(StreamJob& job)
+    {
+        const CookedTextureHeader& header = *job.cooked.header;
+        int lastLevel = static_cast<int>(header.levelCount) - 1;
+        job.started = true;
+        job.format = textureFormat(header.nrComponents);
+        job.internalFormat = compressedInternalFormat(header.format);
+
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = 0; level <= lastLevel; level++)
+        {
+            const CookedTextureLevel& info = job.cooked.levels[level];
+            const unsigned char* data = level == lastLevel ? job.cooked.levelData(level) : nullptr;
+            if (job.internalFormat)
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, job.internalFormat, info.width, info.height, 0, static_cast<GLsizei>(info.size), data);
+            else
+                glTexImage2D(GL_TEXTURE_2D, level, job.format, info.width, info.height, 0, job.format, GL_UNSIGNED_BYTE, data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+        selectCookedLevel(job, std::max(lastLevel - 1, 0));
+        if (lastLevel == 0)
+            job.rowsUploaded = job.levelRows;
+    }
+
+    void selectCookedLevel(StreamJob& job, int level)
+    {
+        const CookedTextureLevel& info = job.cooked.levels[level];
+        job.level = level;
+        job.levelWidth = info.width;
+        job.levelHeight = info.height;
+        job.levelPixels = job.cooked.levelData(level);
+        job.levelRows = job.internalFormat ? (info.height + 3) / 4 : info.height;
+        job.rowSize = static_cast<size_t>(info.size / job.levelRows);
+        job.rowsUploaded = 0;
+    }
+
+    // ϴǰʣУ決ÿһͰBASE_LEVELƵüټϴһ
+    bool uploadLevels(StreamJob& job, size_t& budget)
+    {
+        while (true)
+        {
+            if (!uploadRows(job, budget))
+                return false;
+            if (!job.cookedFile || job.level == 0)
+                return true;
+            glBindTexture(GL_TEXTURE_2D, job.textureID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.level);
+            selectCookedLevel(job, job.level - 1);
+        }
+    }
+
+    // ԤͨPBOϴУPBOԱGPUռûԤľʱfalse
+    bool uploadRows(StreamJob& job, size_t& budget)
+    {
+        size_t rowSize = job.rowSize;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+
+        bool completed = true;
+        while (job.rowsUploaded < job.levelRows)
+        {
+            // ÿ֡ϴһУⵥгԤʱԶ޷
+            if (budget < rowSize && budget != uploadBudget)
+            {
+                completed = false;
+                break;
+            }
+
+            PixelBuffer& pbo = pbos[nextPbo];
+            if (pbo.fence)
+            {
+                GLenum status = glClientWaitSync(pbo.fence, 0, 0);
+                if (status == GL_TIMEOUT_EXPIRED)
+                {
+                    completed = false;
+                    break;
+                }
+                glDeleteSync(pbo.fence);
+                pbo.fence = 0;
+            }
+
+            size_t chunkBytes = std::min(std::max(budget, rowSize), pboSize);
+            int rows = std::max(1, static_cast<int>(chunkBytes / rowSize));
+            rows = std::min(rows, job.levelRows - job.rowsUploaded);
+            size_t bytes = (size_t)rows * rowSize;
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.buffer);
+            if (bytes > pboSize)
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped)
+            {
+                memcpy(mapped, job.levelPixels + (size_t)job.rowsUploaded * rowSize, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                uploadRowRange(job, rows, bytes, (void*)0);
+                pbo.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            else
+            {
+                // ӳʧʱ˻صֱӴڴϴ
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                uploadRowRange(job, rows, bytes, job.levelPixels + (size_t)job.rowsUploaded * rowSize);
+            }
+            if (bytes > pboSize)
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, pboSize, nullptr, GL_STREAM_DRAW);
+
+            job.rowsUploaded += rows;
+            budget -= std::min(budget, bytes);
+            uploadedBytes += bytes;
+            nextPbo = (nextPbo + 1) % pbos.size();
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return completed;
+    }
+
+    // rowsUploadedʼϴrowsУsourceΪPBOƫƻڴַ
+    void uploadRowRange(const StreamJob& job, int rows, size_t bytes, const void* source)
+    {
+        if (job.internalFormat)
+        {
+            int y = job.rowsUploaded * 4;
+            int height = std::min(rows * 4, job.levelHeight - y);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, job.level, 0, y, job.levelWidth, height, job.internalFormat, static_cast<GLsizei>(bytes), source);
+        }
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.rowsUploaded, job.levelWidth, rows, job.format, GL_UNSIGNED_BYTE, source);
+    }
+
+    // 0ȫλָmipΧmipmap決ѴmipͷCPUͼļӳ
+    void finishStreaming(StreamJob& job)
+    {
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        if (!job.cookedFile)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - job.requestTime).count();
+        std::cout << "TextureStreamer: " << job.path << (job.cookedFile ? " (cooked)" : "") << " ready after " << ms << " ms" << std::endl;
+        freeImage(job.image);
+        job.cookedFile.reset();
+    }
+};
+#endif
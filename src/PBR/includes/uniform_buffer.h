@@ -0,0 +1,232 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <gl_extensions.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// GL 4.4/ARB_buffer_storageöٺͺɱ洢ĻԳ־ӳ䣬ӳڼճơ
+// gladֻ3.3ĵļҪԼͼ
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+struct GLBufferStorageFunctions {
+    void (APIENTRYP bufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) = nullptr;
+    bool supported = false;
+};
+
+inline GLBufferStorageFunctions& glBufferStorages()
+{
+    static GLBufferStorageFunctions functions;
+    return functions;
+}
+
+// glBufferStorage֧ʱfalseʱUniformRingglBufferSubDataд
+inline bool loadGLBufferStorage(GLADloadproc load)
+{
+    GLBufferStorageFunctions& functions = glBufferStorages();
+    if (hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage"))
+        functions.bufferStorage = reinterpret_cast<void (APIENTRYP)(GLenum, GLsizeiptr, const void*, GLbitfield)>(load("glBufferStorage"));
+    functions.supported = functions.bufferStorage != nullptr;
+    return functions.supported;
+}
+
+// õuniformİ󶨵㣬ɫͨShader::bindUniformBlock()
+const GLuint FRAME_UNIFORM_BINDING = 0;
+const GLuint OBJECT_UNIFORM_BINDING = 1;
+const int MAX_LIGHTS = 4;
+
+// ɫеFrameUniformsӦstd140ÿ֡һΣPBRպɫá
+// std140vec3ԪزΪ16ֽڣvec4ʾwʹ
+struct FrameUniformData {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 camPos;
+    float padding;
+    glm::vec4 lightPositions[MAX_LIGHTS];
+    glm::vec4 lightColors[MAX_LIGHTS];
+};
+
+// ɫеObjectUniformsӦstd140ÿƵһݡ
+// std140mat3ÿռһvec4mat4ǰ3вͬ
+struct ObjectUniformData {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+
+    void setTransform(const glm::mat4& transform)
+    {
+        model = transform;
+        normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform))));
+    }
+};
+
+// ######################################
+// # Class UniformRing
+// ######################################
+// ÿ֡uniformݵĻλ壺ΪframesΣÿ֡дһΣдǰȴöϴʹʱդ
+// CPUGPU frames-1֧֡ARB_buffer_storageʱ־ӳ䣬дֻһmemcpy
+// ǰglBindBufferRangeƫư󶨣֧ʱÿдִһglBufferSubData
+// һ֡ڴӲƣ֡ʼǰreserve()֡дݣд뱻ܾWRITE_FAILED
+class UniformRing
+{
+public:
+    // write()֡ʱķֵӦݵĻ
+    static const GLintptr WRITE_FAILED = -1;
+
+    // frameCapacityÿ֡дֽ䣩
+    UniformRing(size_t frameCapacity = 64 * 1024, unsigned int frames = 3)
+        : buffer(0), frames(frames), frame(0), offset(0), mapped(nullptr)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        this->alignment = alignment > 0 ? static_cast<size_t>(alignment) : 256;
+        fences = std::vector<GLsync>(frames, (GLsync)0);
+        allocateBuffer(align(frameCapacity));
+    }
+
+    // һT͵ڻλռõֽ䣩ڼreserve()ĴС
+    template<class T>
+    size_t blockSize() const
+    {
+        return align(sizeof(T));
+    }
+
+    // ֤ÿ֡дframeBytesֽڣֻ֮֡ãendFrame()֮beginFrame()֮ǰ
+    // ʱȴGPUжΣ·仺壬֮ǰдƫȫʧЧ
+    void reserve(size_t frameBytes)
+    {
+        frameBytes = align(frameBytes);
+        if (frameBytes <= frameCapacity)
+            return;
+        for (GLsync& fence : fences)
+        {
+            if (!fence)
+                continue;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fence);
+            fence = 0;
+        }
+        size_t capacity = frameCapacity;
+        while (capacity < frameBytes)
+            capacity *= 2;
+        glDeleteBuffers(1, &buffer);
+        mapped = nullptr;
+        allocateBuffer(capacity);
+        offset = 0;
+    }
+
+    // ֡ʼʱãлһΣGPUڶȡöʱȴ
+    void beginFrame()
+    {
+        frame = (frame + 1) % frames;
+        offset = 0;
+        GLsync& fence = fences[frame];
+        if (fence)
+        {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+
+    // ֡ʱãǰڱ֡Ļ֮դ
+    void endFrame()
+    {
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // дһݣڻеƫƣ֮bind()ΰ󶨡֡ʱд룬WRITE_FAILED
+    template<class T>
+    GLintptr write(const T& data)
+    {
+        GLintptr at = allocate(sizeof(T));
+        if (at == WRITE_FAILED)
+            return at;
+        if (mapped)
+        {
+            memcpy(mapped + at, &data, sizeof(T));
+            return at;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, at, sizeof(T), &data);
+        return at;
+    }
+
+    // write()дһݰ󶨵binding֮ĻƴӸð󶨵ȡ
+    void bind(GLuint binding, GLintptr offset, GLsizeiptr size)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+    }
+
+    // дһݲ󶨵binding֡ʱ󶨣false
+    template<class T>
+    bool push(GLuint binding, const T& data)
+    {
+        GLintptr at = write(data);
+        if (at == WRITE_FAILED)
+            return false;
+        bind(binding, at, sizeof(T));
+        return true;
+    }
+
+    bool persistent() const
+    {
+        return mapped != nullptr;
+    }
+
+private:
+    unsigned int buffer;
+    unsigned int frames;
+    unsigned int frame;
+    size_t frameCapacity;
+    size_t alignment;
+    size_t offset;
+    char* mapped;
+    std::vector<GLsync> fences;
+
+    size_t align(size_t size) const
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // framesΡÿcapacityֽڵĻ壬֧ʱ־ӳ
+    void allocateBuffer(size_t capacity)
+    {
+        frameCapacity = capacity;
+        GLsizeiptr size = static_cast<GLsizeiptr>(frameCapacity * frames);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (glBufferStorages().supported)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorages().bufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+            mapped = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+        }
+        if (!mapped)
+            glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // ڵǰз䣬еƫơʱWRITE_FAILEDص׸Ǳ֡д
+    GLintptr allocate(size_t size)
+    {
+        if (offset + size > frameCapacity)
+        {
+            std::cout << "ERROR::UNIFORM_RING::FRAME_CAPACITY_EXCEEDED: " << frameCapacity << " bytes" << std::endl;
+            return WRITE_FAILED;
+        }
+        GLintptr at = static_cast<GLintptr>(frame * frameCapacity + offset);
+        offset += align(size);
+        return at;
+    }
+};
+#endif
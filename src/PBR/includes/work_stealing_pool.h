@@ -0,0 +1,176 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ######################################
+// # Class WorkStealingPool
+// ######################################
+// ݲеأparallelForгС飬طָÿ̸߳ԵĶУ
+// ̴߳Լеβȡ飬Ժ̶߳еͷȡʱĿ飨粻ͬmipҲԶƽ⡣
+// parallelFor߳Ҳ㡣parallelForǶ׵ãҲڶ߳ͬʱ
+class WorkStealingPool
+{
+public:
+    // threadCountΪ߳ߣΪ0ʱʹӲ߳
+    WorkStealingPool(unsigned int threadCount = 0) : body(nullptr), generation(0), stolen(0), activeWorkers(0), stopping(false)
+    {
+        if (threadCount == 0)
+            threadCount = ThreadPool::defaultThreadCount();
+        for (unsigned int i = 0; i < threadCount; i++)
+            queues.emplace_back(new Queue());
+        for (unsigned int i = 1; i < threadCount; i++)
+            workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobCondition.notify_all();
+        for (unsigned int i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    // ִfunction(begin, end)[0, count)ÿgrainԪأȫɺ󷵻
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunkCount = (count + grain - 1) / grain;
+        if (queues.size() == 1 || chunkCount == 1)
+        {
+            for (size_t begin = 0; begin < count; begin += grain)
+                function(begin, std::min(count, begin + grain));
+            return;
+        }
+
+        // i̳߳ʼõiĿ飬ڵĿʵҲ
+        for (size_t q = 0; q < queues.size(); q++)
+        {
+            size_t first = chunkCount * q / queues.size();
+            size_t last = chunkCount * (q + 1) / queues.size();
+            std::lock_guard<std::mutex> lock(queues[q]->mutex);
+            for (size_t c = first; c < last; c++)
+                queues[q]->ranges.push_back(Range{ c * grain, std::min(count, (c + 1) * grain) });
+        }
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            body = &function;
+            activeWorkers = static_cast<unsigned int>(workers.size());
+            generation++;
+        }
+        jobCondition.notify_all();
+
+        runChunks(0);
+
+        // й߳뿪֣֮bodyʧЧ
+        std::unique_lock<std::mutex> lock(jobMutex);
+        doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+        body = nullptr;
+    }
+
+    // ߳
+    unsigned int size() const
+    {
+        return static_cast<unsigned int>(queues.size());
+    }
+
+    // ߳ȡĿӹ쿪ʼۼƣڹ۲츺ؾ
+    size_t stolenChunks() const
+    {
+        return stolen.load();
+    }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;     // 0ڵparallelFor߳
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(size_t, size_t)>* body;
+    unsigned long long generation;
+    std::atomic<size_t> stolen;
+    unsigned int activeWorkers;
+    bool stopping;
+
+    // ȡԼβĿ飬δͷȡжжʱ
+    bool nextChunk(size_t self, Range& range)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[self]->mutex);
+            if (!queues[self]->ranges.empty())
+            {
+                range = queues[self]->ranges.back();
+                queues[self]->ranges.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); k++)
+        {
+            Queue& victim = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.ranges.empty())
+            {
+                range = victim.ranges.front();
+                victim.ranges.pop_front();
+                stolen++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runChunks(size_t self)
+    {
+        Range range;
+        while (nextChunk(self, range))
+            (*body)(range.begin, range.end);
+    }
+
+    void workerLoop(size_t self)
+    {
+        unsigned long long seenGeneration = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping)
+                    return;
+                seenGeneration = generation;
+            }
+            runChunks(self);
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if (--activeWorkers == 0)
+                doneCondition.notify_all();
+        }
+    }
+};
+#endif
@@ -11,20 +11,39 @@
 #include <imgui/imgui_impl_opengl3.h>
 
 #include <shader.h>
+#include <brdf_lut.h>
 #include <camera.h>
+#include <cooked_texture.h>
+#include <environment_library.h>
+#include <file_system.h>
+#include <gl_state_cache.h>
+#include <material.h>
+#include <material_atlas.h>
+#include <hdr_image.h>
+#include <ibl_compute.h>
+#include <ibl_upload.h>
+#include <mesh_batch.h>
 #include <model.h>
-
+#include <model_loader.h>
+#include <scene_registry.h>
+#include <thread_pool.h>
+#include <texture_cache.h>
+#include <texture_loader.h>
+#include <texture_streamer.h>
+#include <uniform_buffer.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
-void renderPbrModel(unsigned int albedoMap, unsigned int normalMap, unsigned int metallicMap, unsigned int roughnessMap, unsigned int aoMap, Shader& pbrShader, Model inputModel, glm::mat4 model);
+
 void renderSphere();
 void renderCube();
-void renderQuad();
 
 // 窗体宽高
 const unsigned int SCR_WIDTH = 1280;
@@ -40,12 +59,45 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char** argv)
 {
+	// --bench-decode：加载完成后测试不同线程数下的纹理解码耗时
+	// --sync-textures：启动时阻塞等待全部纹理加载完成，而不是异步流式加载
+	// --separate-maps：不使用打包的ORM贴图，metallic/roughness/ao分别加载和采样
+	// --hdr-rgb9e5：HDR环境贴图以RGB9E5（每像素4字节）而不是RGB16F（每像素6字节）上传
+	// --rebake-ibl：忽略IBL缓存重新烘焙（并覆盖缓存），用于测量各烘焙阶段的GPU耗时
+	// --compute-ibl：创建GL 4.3上下文，用计算着色器烘焙IBL；不支持时退回3.3和片段着色器烘焙
+	// --ibl-swap-budget <毫秒>：运行时切换环境贴图时每帧用于上传IBL纹理的时间预算
+	bool benchDecode = false;
+	bool syncTextures = false;
+	bool useOrmMaps = true;
+	HdrPixelFormat hdrFormat = HDR_PIXELS_RGB16F;
+	bool rebakeIbl = false;
+	bool computeIbl = false;
+	double iblSwapBudgetMs = 2.0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench-decode") == 0)
+			benchDecode = true;
+		else if (strcmp(argv[i], "--sync-textures") == 0)
+			syncTextures = true;
+		else if (strcmp(argv[i], "--separate-maps") == 0)
+			useOrmMaps = false;
+		else if (strcmp(argv[i], "--hdr-rgb9e5") == 0)
+			hdrFormat = HDR_PIXELS_RGB9E5;
+		else if (strcmp(argv[i], "--rebake-ibl") == 0)
+			rebakeIbl = true;
+		else if (strcmp(argv[i], "--compute-ibl") == 0)
+			computeIbl = true;
+		else if (strcmp(argv[i], "--ibl-swap-budget") == 0 && i + 1 < argc)
+			iblSwapBudgetMs = atof(argv[++i]);
+	}
+	bool streamTextures = !benchDecode && !syncTextures;
+
 	// 初始化glfw
 	glfwInit();
-	// 设置OpenGL的主要和次要版本为3.3
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	// 设置OpenGL的主要和次要版本为3.3（计算着色器烘焙IBL时为4.3）
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, computeIbl ? 4 : 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	// 设置多重采样样本数量为4，用于抗锯齿
 	glfwWindowHint(GLFW_SAMPLES, 4);
@@ -54,6 +106,13 @@ int main()
 
 	// 创建glfw窗体
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+	if (window == NULL && computeIbl)
+	{
+		std::cout << "OpenGL 4.3 not available, baking IBL with fragment shaders" << std::endl;
+		computeIbl = false;
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+	}
 	// 设置当前的上下文为此窗口
 	glfwMakeContextCurrent(window);
 	if (window == NULL)
@@ -76,6 +135,20 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
+	// glad只加载3.3核心函数，计算着色器的函数另外加载
+	if (computeIbl && !(hasGLVersion(4, 3) && loadGLCompute((GLADloadproc)glfwGetProcAddress)))
+	{
+		std::cout << "Compute shaders not available, baking IBL with fragment shaders" << std::endl;
+		computeIbl = false;
+	}
+	// 着色器程序二进制缓存的函数（GL 4.1/ARB_get_program_binary），不支持时每次启动从源码编译
+	loadGLProgramBinary((GLADloadproc)glfwGetProcAddress);
+	// 支持KHR_parallel_shader_compile时由驱动在后台线程中编译着色器
+	loadGLParallelShaderCompile((GLADloadproc)glfwGetProcAddress);
+	// 支持ARB_buffer_storage时uniform环形缓冲持久映射
+	loadGLBufferStorage((GLADloadproc)glfwGetProcAddress);
+	// 支持glCopyImageSubData（GL 4.3/ARB_copy_image）时，坦克各部件兼容的材质复制到纹理数组中合并绘制
+	loadGLCopyImage((GLADloadproc)glfwGetProcAddress);
 
 	// 初始化ImGui上下文和设置风格
 	IMGUI_CHECKVERSION();
@@ -93,89 +166,172 @@ int main()
 	// 启用无缝立方贴图采样，为预滤镜贴图的低mip级别
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-	// 构建和编译着色器
-	Shader pbrShader("pbr.vs", "pbr.fs");
-	Shader equirectangularToCubemapShader("cubemap.vs", "equirectangular_to_cubemap.fs");
-	Shader irradianceShader("cubemap.vs", "irradiance_convolution.fs");
-	Shader prefilterShader("cubemap.vs", "prefilter.fs");
-	Shader brdfShader("brdf.vs", "brdf.fs");
-	Shader backgroundShader("background.vs", "background.fs");
-
-	// 配置着色器中的纹理单元
-	pbrShader.use();
-	pbrShader.setInt("irradianceMap", 0);
-	pbrShader.setInt("prefilterMap", 1);
-	pbrShader.setInt("brdfLUT", 2);
-	pbrShader.setInt("albedoMap", 3);
-	pbrShader.setInt("normalMap", 4);
-	pbrShader.setInt("metallicMap", 5);
-	pbrShader.setInt("roughnessMap", 6);
-	pbrShader.setInt("aoMap", 7);
-
-	backgroundShader.use();
-	backgroundShader.setInt("environmentMap", 0);
+	// 构建和编译着色器，有程序二进制缓存时直接加载。全部延迟创建：先提交所有编译，驱动可以并行编译，
+	// 纹理单元等uniforms在纹理和模型加载之后（第一次使用时）才设置，编译与加载重叠
+	std::chrono::high_resolution_clock::time_point shaderStart = std::chrono::high_resolution_clock::now();
+	Shader pbrShader("pbr.vs", "pbr.fs", nullptr, std::string(), true);
+	// 使用打包ORM贴图的变体：三次标量贴图采样合并为一次
+	Shader pbrOrmShader("pbr.vs", "pbr.fs", nullptr, "#define USE_ORM_MAP\n", true);
+	// 材质图集的变体：贴图为纹理数组，按顶点的层号采样
+	Shader pbrArrayShader("pbr.vs", "pbr.fs", nullptr, "#define USE_MATERIAL_ARRAY\n", true);
+	Shader pbrOrmArrayShader("pbr.vs", "pbr.fs", nullptr, "#define USE_MATERIAL_ARRAY\n#define USE_ORM_MAP\n", true);
+	Shader equirectangularToCubemapShader("cubemap.vs", "equirectangular_to_cubemap.fs", nullptr, std::string(), true);
+	Shader prefilterShader("cubemap.vs", "prefilter.fs", nullptr, std::string(), true);
+	Shader backgroundShader("background.vs", "background.fs", nullptr, std::string(), true);
+	std::cout << "Shaders: submitted in " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - shaderStart).count() << " ms"
+			  << (glParallelShaderCompile().supported ? " (parallel compile)" : "") << (glProgramBinaries().supported ? "" : " (program binaries not supported)") << std::endl;
+	// 加载期间轮询GL_COMPLETION_STATUS_KHR，只解析驱动已编译完成的程序，不阻塞；其余的在第一次使用时等待
+	Shader* deferredShaders[] = { &pbrShader, &pbrOrmShader, &pbrArrayShader, &pbrOrmArrayShader,
+								  &equirectangularToCubemapShader, &prefilterShader, &backgroundShader };
+	unsigned int shadersResolvedInBackground = 0;
+	auto pollShaders = [&]() {
+		shadersResolvedInBackground = 0;
+		for (Shader* shader : deferredShaders)
+			if (shader->resolveIfReady())
+				shadersResolvedInBackground++;
+	};
 
-	// 加载PBR材料纹理
+	// 加载PBR材料纹理：图像在线程池中并行解码。
+	// 流式模式下立即返回占位纹理，之后每帧通过PBO按预算上传；同步模式下主线程按顺序执行glTexImage2D上传
+	ThreadPool decodePool;
+	TextureBatch textureBatch(decodePool);
+	TextureStreamer textureStreamer(decodePool);
+	// 占位颜色：法线贴图使用切线空间的平坦法线，其余使用中灰色
+	const glm::vec4 flatNormal(0.5f, 0.5f, 1.0f, 1.0f);
+	const glm::vec4 grey(0.5f, 0.5f, 0.5f, 1.0f);
+	// 经过全局纹理缓存：同一图像（按路径或内容）只加载一次
+	auto loadMaterialTexture = [&](const std::string& path, bool flipVertically, const glm::vec4& placeholder) {
+		return TextureCache::instance().acquire(path, flipVertically, [&](const std::string& filename) {
+			return streamTextures ? textureStreamer.request(filename, flipVertically, placeholder) : textureBatch.add(filename, flipVertically);
+		});
+	};
+	// 有AssetCooker生成的ORM贴图（<前缀>orm.tga或其烘焙文件）时，metallic/roughness/ao只加载这一张。
+	// 每个材质按是否有ORM贴图选择着色器
+	auto loadMaterial = [&](const std::string& prefix, const std::string& extension, bool flipVertically) {
+		PbrMaterialMaps maps;
+		maps.albedo = loadMaterialTexture(prefix + "albedo" + extension, flipVertically, grey);
+		maps.normal = loadMaterialTexture(prefix + "normal" + extension, flipVertically, flatNormal);
+		std::string ormPath = prefix + "orm.tga";
+		if (useOrmMaps && (fileExists(ormPath) || fileExists(cookedTexturePath(ormPath))))
+			maps.orm = loadMaterialTexture(ormPath, flipVertically, grey);
+		else
+		{
+			maps.metallic = loadMaterialTexture(prefix + "metallic" + extension, flipVertically, grey);
+			maps.roughness = loadMaterialTexture(prefix + "roughness" + extension, flipVertically, grey);
+			maps.ao = loadMaterialTexture(prefix + "ao" + extension, flipVertically, grey);
+		}
+		Material material;
+		material.maps = maps;
+		material.shader = maps.orm ? &pbrOrmShader : &pbrShader;
+		return material;
+	};
 	// 黄金材质
-	unsigned int goldAlbedoMap = loadTexture("resources/textures/pbr/gold/albedo.png");
-	unsigned int goldNormalMap = loadTexture("resources/textures/pbr/gold/normal.png");
-	unsigned int goldMetallicMap = loadTexture("resources/textures/pbr/gold/metallic.png");
-	unsigned int goldRoughnessMap = loadTexture("resources/textures/pbr/gold/roughness.png");
-	unsigned int goldAOMap = loadTexture("resources/textures/pbr/gold/ao.png");
-
-	stbi_set_flip_vertically_on_load(true);
-	unsigned int modelAlbedoMap0 = loadTexture("resources/objects/pokeball/albedo.png");
-	unsigned int modelNormalMap0 = loadTexture("resources/objects/pokeball/normal.png");
-	unsigned int modelMetallicMap0 = loadTexture("resources/objects/pokeball/metallic.png");
-	unsigned int modelRoughnessMap0 = loadTexture("resources/objects/pokeball/roughness.png");
-	unsigned int modelAoMapModel0 = loadTexture("resources/objects/pokeball/ao.png");
-	cout << "loadTexture from " << "resources/objects/pokeball" << endl;
-
-	stbi_set_flip_vertically_on_load(false);
-	unsigned int modelAlbedoMap1 = loadTexture("resources/objects/tank/hull_albedo.jpg");
-	unsigned int modelNormalMap1 = loadTexture("resources/objects/tank/hull_normal.jpg");
-	unsigned int modelMetallicMap1 = loadTexture("resources/objects/tank/hull_metallic.jpg");
-	unsigned int modelRoughnessMap1 = loadTexture("resources/objects/tank/hull_roughness.jpg");
-	unsigned int modelAoMapModel1 = loadTexture("resources/objects/tank/hull_ao.jpg");
-
-	unsigned int modelAlbedoMap2 = loadTexture("resources/objects/tank/track_albedo.jpg");
-	unsigned int modelNormalMap2 = loadTexture("resources/objects/tank/track_normal.jpg");
-	unsigned int modelMetallicMap2 = loadTexture("resources/objects/tank/track_metallic.jpg");
-	unsigned int modelRoughnessMap2 = loadTexture("resources/objects/tank/track_roughness.jpg");
-	unsigned int modelAoMapModel2 = loadTexture("resources/objects/tank/track_ao.jpg");
-
-	unsigned int modelAlbedoMap3 = loadTexture("resources/objects/tank/turret_albedo.jpg");
-	unsigned int modelNormalMap3 = loadTexture("resources/objects/tank/turret_normal.jpg");
-	unsigned int modelMetallicMap3 = loadTexture("resources/objects/tank/turret_metallic.jpg");
-	unsigned int modelRoughnessMap3 = loadTexture("resources/objects/tank/turret_roughness.jpg");
-	unsigned int modelAoMapModel3 = loadTexture("resources/objects/tank/turret_ao.jpg");
-
-	unsigned int modelAlbedoMap4 = loadTexture("resources/objects/tank/wheels_albedo.jpg");
-	unsigned int modelNormalMap4 = loadTexture("resources/objects/tank/wheels_normal.jpg");
-	unsigned int modelMetallicMap4 = loadTexture("resources/objects/tank/wheels_metallic.jpg");
-	unsigned int modelRoughnessMap4 = loadTexture("resources/objects/tank/wheels_roughness.jpg");
-	unsigned int modelAoMapModel4 = loadTexture("resources/objects/tank/wheels_ao.jpg");
-
-	unsigned int modelAlbedoMap5 = loadTexture("resources/objects/tank/floor_albedo.jpg");
-	unsigned int modelNormalMap5 = loadTexture("resources/objects/tank/floor_normal.jpg");
-	unsigned int modelMetallicMap5 = loadTexture("resources/objects/tank/floor_metallic.jpg");
-	unsigned int modelRoughnessMap5 = loadTexture("resources/objects/tank/floor_roughness.jpg");
-	unsigned int modelAoMapModel5 = loadTexture("resources/objects/tank/floor_ao.jpg");
-	cout << "loadTexture from " << "resources/objects/tank" << endl;
-
-	// 实例化模型
-	Model pokeball("resources/objects/pokeball/PokeBall.obj");
-	cout << "init model finish " << "resources/objects/pokeball/PokeBall.obj" << endl;
-	Model hull("resources/objects/tank/hull.obj");
-	cout << "init model finish " << "resources/objects/tank/hull.obj" << endl;
-	Model track("resources/objects/tank/track.obj");
-	cout << "init model finish " << "resources/objects/tank/track.obj" << endl;
-	Model turret("resources/objects/tank/turret.obj");
-	cout << "init model finish" << "resources/objects/tank/turret.obj" << endl;
-	Model wheels("resources/objects/tank/wheels.obj");
-	cout << "init model finish " << "resources/objects/tank/wheels.obj" << endl;
-	Model floor("resources/objects/tank/floor.obj");
-	cout << "init model finish " << "resources/objects/tank/floor.obj" << endl;
+	Material goldMaterial = loadMaterial("resources/textures/pbr/gold/", ".png", false);
+	// 模型材质
+	Material pokeballMaterial = loadMaterial("resources/objects/pokeball/", ".png", true);
+	// 坦克各部件的材质，顺序与下面的tankModels相同：hull、track、turret、wheels、floor
+	std::vector<Material> tankMaterials = {
+		loadMaterial("resources/objects/tank/hull_", ".jpg", false),
+		loadMaterial("resources/objects/tank/track_", ".jpg", false),
+		loadMaterial("resources/objects/tank/turret_", ".jpg", false),
+		loadMaterial("resources/objects/tank/wheels_", ".jpg", false),
+		loadMaterial("resources/objects/tank/floor_", ".jpg", false)
+	};
+
+	if (!streamTextures)
+		textureBatch.finish();
+	pollShaders();
+	cout << "loadTexture from " << "resources/objects/pokeball" << ", " << "resources/objects/tank" << endl;
+	if (benchDecode)
+		textureBatch.benchmark();
+
+	// 实例化模型：各模型的导入在modelPool中并行执行，GL上传在finish()中由主线程按完成顺序进行
+	// .obj在单独的线程池中并行解析，不排在流式纹理的解码任务和模型导入任务之后
+	ThreadPool meshPool;
+	ThreadPool modelPool;
+	ModelLoader modelLoader(modelPool, streamTextures ? &textureStreamer : nullptr, &meshPool);
+	// HDR环境贴图在后台解码（扫描线在meshPool中并行解码），与模型导入重叠，IBL预计算前只需等待结果。
+	// 先检查IBL缓存，命中时不需要解码HDR；未命中时烘焙用的GGX采样表也在后台生成
+	const char* hdrPath = "resources/textures/hdr/dancing_hall_4k.hdr";
+	IblBakeParams iblParams;
+	MappedFile iblCacheFile;
+	IblCacheView iblCache;
+	uint64_t iblBakeHash = 0, hdrHash = 0, hdrSize = 0;
+	std::vector<GgxSample> prefilterTable;
+	std::vector<uint32_t> prefilterSampleCounts;
+	uint32_t prefilterTableWidth = 0;
+	std::future<HdrImage> environmentImage = modelPool.enqueue([&] {
+		HdrImage image;
+		iblBakeHash = iblBakeKey(iblParams, iblBakeShaderPaths());
+		if (!openIblCache(hdrPath, iblBakeHash, iblCacheFile, iblCache, hdrHash, hdrSize) || rebakeIbl)
+		{
+			iblCache = IblCacheView();
+			iblCacheFile.close();
+			decodeHdrImage(hdrPath, hdrFormat, true, image, &meshPool);
+			prefilterTable = prefilterSampleTable(iblParams, prefilterTableWidth, prefilterSampleCounts);
+		}
+		return image;
+	});
+	std::future<std::unique_ptr<Model>> pokeballModel = modelLoader.load("resources/objects/pokeball/PokeBall.obj");
+	std::future<std::unique_ptr<Model>> hullModel = modelLoader.load("resources/objects/tank/hull.obj");
+	std::future<std::unique_ptr<Model>> trackModel = modelLoader.load("resources/objects/tank/track.obj");
+	std::future<std::unique_ptr<Model>> turretModel = modelLoader.load("resources/objects/tank/turret.obj");
+	std::future<std::unique_ptr<Model>> wheelsModel = modelLoader.load("resources/objects/tank/wheels.obj");
+	std::future<std::unique_ptr<Model>> floorModel = modelLoader.load("resources/objects/tank/floor.obj");
+	modelLoader.finish(pollShaders);
+	pollShaders();
+	if (glParallelShaderCompile().supported)
+		std::cout << "Shaders: " << shadersResolvedInBackground << "/" << sizeof(deferredShaders) / sizeof(deferredShaders[0]) << " compiled in the background during loading" << std::endl;
+	std::unique_ptr<Model> pokeball = pokeballModel.get();
+	std::unique_ptr<Model> hull = hullModel.get();
+	std::unique_ptr<Model> track = trackModel.get();
+	std::unique_ptr<Model> turret = turretModel.get();
+	std::unique_ptr<Model> wheels = wheelsModel.get();
+	std::unique_ptr<Model> floor = floorModel.get();
+	cout << "init model finish " << "resources/objects/pokeball" << ", " << "resources/objects/tank" << endl;
+	TextureCache::instance().printStats();
+
+	// 注册场景中的可渲染对象：之后每帧只更新变换，通过句柄绘制，不再复制模型
+	SceneRegistry scene;
+	auto addRenderable = [&](const Model& model, const Material& material) {
+		return scene.addRenderable(scene.addModel(model), scene.addMaterial(material));
+	};
+	MaterialHandle pokeballMaterialHandle = scene.addMaterial(pokeballMaterial);
+	RenderableHandle pokeballRenderable = scene.addRenderable(scene.addModel(*pokeball), pokeballMaterialHandle);
+	// 坦克各部件使用同一变换：贴图尺寸和格式相同的部件，材质复制到一个图集（纹理数组）中，网格合并后用一次绘制完成。
+	// 图集从已加载的贴图复制，流式加载时要等全部贴图上传之后才能构建，此前各部件分别绘制
+	const Model* tankModels[] = { hull.get(), track.get(), turret.get(), wheels.get(), floor.get() };
+	std::vector<RenderableHandle> tankRenderables;
+	for (size_t part = 0; part < tankMaterials.size(); part++)
+		tankRenderables.push_back(addRenderable(*tankModels[part], tankMaterials[part]));
+	bool tankBatched = false;
+	auto batchTankParts = [&]() {
+		tankBatched = true;
+		for (const std::vector<size_t>& group : MaterialAtlas::group(tankMaterials))
+		{
+			std::vector<Material> materials;
+			for (size_t part : group)
+				materials.push_back(tankMaterials[part]);
+			MaterialAtlas atlas;
+			if (!atlas.build(materials, materials[0].maps.orm ? &pbrOrmArrayShader : &pbrArrayShader))
+				continue;
+			MeshBatch batch;
+			for (size_t layer = 0; layer < group.size(); layer++)
+				batch.add(*tankModels[group[layer]], static_cast<unsigned int>(layer));
+			batch.build();
+			tankRenderables.push_back(scene.addRenderable(scene.addModel(batch), scene.addMaterial(atlas.material())));
+			// 合并后各部件不再单独绘制，图集中已有贴图的副本：从注册表中移除各部件（清空其材质的贴图），
+			// 再释放原来的2D贴图，之后没有任何材质引用这些纹理ID
+			for (size_t part : group)
+			{
+				scene.removeRenderable(tankRenderables[part]);
+				for (int slot = 0; slot < MATERIAL_MAP_SLOTS; slot++)
+					TextureCache::instance().release(materialMapSlot(tankMaterials[part].maps, slot));
+				tankMaterials[part].maps = PbrMaterialMaps();
+			}
+			std::cout << "Material atlas: " << group.size() << " tank parts in one draw" << std::endl;
+		}
+	};
 
 	// 定义光源的位置和颜色
 	glm::vec3 lightPositions[] = {
@@ -185,49 +341,14 @@ int main()
 		glm::vec3(1000.0f, 1000.0f, 1000.0f)
 	};
 
-	// PBR: 设置帧缓存
-	unsigned int captureFBO;
-	unsigned int captureRBO;
-	glGenFramebuffers(1, &captureFBO);
-	glGenRenderbuffers(1, &captureRBO);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-	// PBR: 加载HDR环境贴图
-	stbi_set_flip_vertically_on_load(true);
-	int width, height, nrComponents;
-	float* data = stbi_loadf("resources/textures/hdr/dancing_hall_4k.hdr", &width, &height, &nrComponents, 0);
-	unsigned int hdrTexture;
-	if (data)
-	{
-		// 创建纹理
-		glGenTextures(1, &hdrTexture);
-		glBindTexture(GL_TEXTURE_2D, hdrTexture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
-
-		// 纹理参数设置
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Failed to load HDR image." << std::endl;
-	}
-
-	// PBR: 设置用于渲染的立方贴图并附加到帧缓存
+	// PBR: 设置用于渲染的立方贴图并附加到帧缓存。计算着色器以图像写入立方图，GL_RGB16F不是图像格式，改用GL_RGBA16F
+	GLenum iblCubeFormat = computeIbl ? GL_RGBA16F : GL_RGB16F;
 	unsigned int envCubemap;
 	glGenTextures(1, &envCubemap);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 	for (unsigned int i = 0; i < 6; ++i)
 	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, iblCubeFormat, iblParams.environmentSize, iblParams.environmentSize, 0, GL_RGB, GL_FLOAT, nullptr);
 	}
 	// 立方贴图的参数设置
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -235,83 +356,9 @@ int main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// PBR: 为6个立方贴图面方向设置投影和视图矩阵
-	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-	// 定义6个面的视图矩阵
-	glm::mat4 captureViews[] =
-	{
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-	};
-
-	// PBR: 将HDR等矩形环境贴图转换为立方贴图等效物
-	equirectangularToCubemapShader.use();
-	equirectangularToCubemapShader.setInt("equirectangularMap", 0);
-	equirectangularToCubemapShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdrTexture);
-
-	glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		renderCube();
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// 让OpenGL从第一个mip面生成mipmaps（对抗可见的点伪像）
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-	// PBR: 创建辐照率立方图，并将捕捉FBO重新调整为辐照率尺寸。
-	unsigned int irradianceMap;
-	glGenTextures(1, &irradianceMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		// 为每个立方体贴图面分配内存
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-	}
-	// 设置纹理参数
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// 绑定帧缓冲对象和渲染缓冲对象
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-
-	// PBR: 通过卷积解决漫反射积分，创建辐照率（立方图）映射。
-	irradianceShader.use();
-	irradianceShader.setInt("environmentMap", 0);
-	irradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-	// 配置视口大小
-	glViewport(0, 0, 32, 32);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		irradianceShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		// 渲染立方体
-		renderCube();
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// 以图像绑定的纹理必须是完整的，先分配全部mip级别
+	if (computeIbl)
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
 	// PBR: 创建预过滤立方图，并将捕捉FBO重新调整为预过滤尺寸。
 	unsigned int prefilterMap;
@@ -320,7 +367,7 @@ int main()
 	for (unsigned int i = 0; i < 6; ++i)
 	{
 		// 为每个立方体贴图面分配内存
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, iblCubeFormat, iblParams.prefilterSize, iblParams.prefilterSize, 0, GL_RGB, GL_FLOAT, nullptr);
 	}
 	// 设置纹理参数
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -331,70 +378,260 @@ int main()
 	// 生成立方图的mipmap
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	// PBR: 对环境光进行准蒙特卡洛模拟，创建预过滤（立方图）映射
-	prefilterShader.use();
-	prefilterShader.setInt("environmentMap", 0);
-	prefilterShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+	// PBR: BRDF 2D LUT在构建时生成并嵌入程序，直接上传
+	unsigned int brdfLUTTexture = uploadBrdfLut();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	unsigned int maxMipLevels = 5;
-	for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+	// PBR: IBL缓存命中时直接上传预计算结果，否则加载HDR并在GPU上烘焙，然后读回写入缓存
+	HdrImage environment = environmentImage.get();
+	IblTextures iblTextures = { envCubemap, prefilterMap };
+	IrradianceSH irradianceSH;
+	std::chrono::high_resolution_clock::time_point iblStart = std::chrono::high_resolution_clock::now();
+	if (iblCache.header)
 	{
-		// 根据mip级别调整帧缓冲对象的大小
-		unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-		unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-		glViewport(0, 0, mipWidth, mipHeight);
-
-		float roughness = (float)mip / (float)(maxMipLevels - 1);
-		prefilterShader.setFloat("roughness", roughness);
-		for (unsigned int i = 0; i < 6; ++i)
+		uploadIblCache(iblCache, iblTextures);
+		irradianceSH = iblCache.header->irradianceSH;
+		iblCacheFile.close();
+		std::cout << "IBL: loaded from " << iblCachePath(hdrPath) << " in "
+				  << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - iblStart).count() << " ms" << std::endl;
+	}
+	else
+	{
+		// PBR: 加载HDR环境贴图
+		unsigned int hdrTexture = 0;
+		if (!environment.pixels.empty())
 		{
-			prefilterShader.setMat4("view", captureViews[i]);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+			// 解码时已垂直翻转并转换为半精度/RGB9E5，直接上传
+			glGenTextures(1, &hdrTexture);
+			glBindTexture(GL_TEXTURE_2D, hdrTexture);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			if (environment.format == HDR_PIXELS_RGB9E5)
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB9_E5, environment.width, environment.height, 0, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, environment.pixels.data());
+			else
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, environment.width, environment.height, 0, GL_RGB, GL_HALF_FLOAT, environment.pixels.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			std::cout << "HDR: " << environment.width << "x" << environment.height << " decoded in " << environment.decodeMs << " ms ("
+					  << environment.pixels.size() / (1024 * 1024) << " MB)" << std::endl;
+			std::vector<unsigned char>().swap(environment.pixels);
+		}
+		else
+		{
+			// 不支持的HDR文件（如旧式RLE）退回stb_image
+			int width, height, nrComponents;
+			float* data = stbi_loadf(hdrPath, &width, &height, &nrComponents, 0);
+			if (data)
+			{
+				// 垂直翻转（不使用stb_image的全局翻转开关，以免影响其他线程中的解码）
+				flipImageVertically(data, width, height, nrComponents * sizeof(float));
+
+				// 创建纹理
+				glGenTextures(1, &hdrTexture);
+				glBindTexture(GL_TEXTURE_2D, hdrTexture);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
+
+				// 纹理参数设置
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			renderCube();
+				stbi_image_free(data);
+			}
+			else
+			{
+				std::cout << "Failed to load HDR image." << std::endl;
+			}
 		}
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// PBR: 从使用的BRDF方程生成2D LUT
-	unsigned int brdfLUTTexture;
-	glGenTextures(1, &brdfLUTTexture);
+		// 各烘焙阶段（环境立方图、辐照度球谐、预过滤）的GPU耗时
+		unsigned int bakeQueries[3];
+		glGenQueries(3, bakeQueries);
+		// 预过滤的GGX采样表
+		unsigned int prefilterTableTexture = uploadGgxSampleTable(prefilterTable, prefilterTableWidth, iblParams.prefilterMipLevels);
 
-	// PBR: 从使用的BRDF方程生成2D LUT。
-	glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-	// 设置纹理参数
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		if (computeIbl)
+		{
+			// PBR: 计算着色器路径：每个阶段一次调度，用imageStore直接写入目标纹理，辐照度球谐在GPU上投影和归约
+			IblComputeBaker computeBaker(iblParams);
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[0]);
+			computeBaker.environment(hdrTexture, envCubemap);
+			glEndQuery(GL_TIME_ELAPSED);
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[1]);
+			irradianceSH = computeBaker.irradianceSH(envCubemap);
+			glEndQuery(GL_TIME_ELAPSED);
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[2]);
+			computeBaker.prefilter(envCubemap, prefilterMap, prefilterTableTexture, prefilterSampleCounts);
+			glEndQuery(GL_TIME_ELAPSED);
+		}
+		else
+		{
+			// PBR: 设置帧缓存
+			unsigned int captureFBO;
+			unsigned int captureRBO;
+			glGenFramebuffers(1, &captureFBO);
+			glGenRenderbuffers(1, &captureRBO);
+
+			GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+			glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, iblParams.environmentSize, iblParams.environmentSize);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+
+			// PBR: 为6个立方贴图面方向设置投影和视图矩阵
+			glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+			// 定义6个面的视图矩阵
+			glm::mat4 captureViews[] =
+			{
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+				glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+			};
+
+			// PBR: 将HDR等矩形环境贴图转换为立方贴图等效物
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[0]);
+			equirectangularToCubemapShader.use();
+			equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+			equirectangularToCubemapShader.setMat4("projection", captureProjection);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, hdrTexture);
+
+			glViewport(0, 0, iblParams.environmentSize, iblParams.environmentSize); // don't forget to configure the viewport to the capture dimensions.
+			GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+			for (unsigned int i = 0; i < 6; ++i)
+			{
+				equirectangularToCubemapShader.setMat4("view", captureViews[i]);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// 配置捕捉帧缓冲对象并使用BRDF着色器渲染屏幕空间四边形
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
+				renderCube();
+			}
+			GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			// 让OpenGL从第一个mip面生成mipmaps（对抗可见的点伪像）
+			glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			// PBR: 漫反射辐照度不再卷积成立方图，而是读回环境立方图的一个低mip级别投影为L2球谐系数
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[1]);
+			irradianceSH = readIrradianceSH(envCubemap, iblParams);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			// PBR: 对环境光进行准蒙特卡洛模拟，创建预过滤（立方图）映射。采样方向和mip级别来自预先计算的采样表，每级的采样数不同
+			glBeginQuery(GL_TIME_ELAPSED, bakeQueries[2]);
+			prefilterShader.use();
+			prefilterShader.setInt("environmentMap", 0);
+			prefilterShader.setInt("sampleTable", 1);
+			prefilterShader.setMat4("projection", captureProjection);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, prefilterTableTexture);
+
+			GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+			unsigned int maxMipLevels = iblParams.prefilterMipLevels;
+			for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+			{
+				// 根据mip级别调整帧缓冲对象的大小
+				unsigned int mipWidth = static_cast<unsigned int>(iblParams.prefilterSize * std::pow(0.5, mip));
+				unsigned int mipHeight = static_cast<unsigned int>(iblParams.prefilterSize * std::pow(0.5, mip));
+				glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+				glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+				glViewport(0, 0, mipWidth, mipHeight);
+
+				prefilterShader.setInt("sampleRow", mip);
+				prefilterShader.setInt("sampleCount", prefilterSampleCounts[mip]);
+				for (unsigned int i = 0; i < 6; ++i)
+				{
+					prefilterShader.setMat4("view", captureViews[i]);
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
 
-	glViewport(0, 0, 512, 512);
-	brdfShader.use();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderQuad();
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					renderCube();
+				}
+			}
+			GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
+			glEndQuery(GL_TIME_ELAPSED);
+			glDeleteFramebuffers(1, &captureFBO);
+			glDeleteRenderbuffers(1, &captureRBO);
+		}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glFinish();
+		GLuint64 bakeNs[3];
+		for (int i = 0; i < 3; ++i)
+			glGetQueryObjectui64v(bakeQueries[i], GL_QUERY_RESULT, &bakeNs[i]);
+		std::cout << "IBL: baked with " << (computeIbl ? "compute" : "fragment") << " shaders in "
+				  << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - iblStart).count() << " ms (GPU: environment "
+				  << bakeNs[0] / 1e6 << " ms, sh " << bakeNs[1] / 1e6 << " ms, prefilter " << bakeNs[2] / 1e6 << " ms; prefilter samples";
+		for (unsigned int mip = 0; mip < iblParams.prefilterMipLevels; ++mip)
+			std::cout << (mip == 0 ? " " : "/") << prefilterSampleCount(iblParams, mip);
+		std::cout << ")" << std::endl;
+		// 烘焙完成后采样表和等矩形HDR纹理不再需要
+		glDeleteQueries(3, bakeQueries);
+		glDeleteTextures(1, &prefilterTableTexture);
+		glDeleteTextures(1, &hdrTexture);
+		if (hdrTexture != 0 && hdrSize != 0 && saveIblCache(hdrPath, hdrHash, hdrSize, iblBakeHash, iblParams, iblTextures, irradianceSH))
+			std::cout << "IBL: cached to " << iblCachePath(hdrPath) << std::endl;
+	}
 
+	// 配置着色器中的纹理单元（PBR着色器第一次使用，此时才等待其编译完成）。图集变体的贴图使用相同的纹理单元
+	for (Shader* shader : { &pbrShader, &pbrArrayShader })
+	{
+		shader->use();
+		shader->setInt("prefilterMap", 1);
+		shader->setInt("brdfLUT", 2);
+		shader->setInt("albedoMap", 3);
+		shader->setInt("normalMap", 4);
+		shader->setInt("metallicMap", 5);
+		shader->setInt("roughnessMap", 6);
+		shader->setInt("aoMap", 7);
+	}
+	for (Shader* shader : { &pbrOrmShader, &pbrOrmArrayShader })
+	{
+		shader->use();
+		shader->setInt("prefilterMap", 1);
+		shader->setInt("brdfLUT", 2);
+		shader->setInt("albedoMap", 3);
+		shader->setInt("normalMap", 4);
+		shader->setInt("ormMap", 5);
+	}
+	backgroundShader.use();
+	backgroundShader.setInt("environmentMap", 0);
 
-	// 在渲染前初始化着色器的uniforms变量
+	// 在渲染前初始化着色器的uniforms变量。相机、光源和物体变换在uniform块中，通过绑定点由所有程序共用
 	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-	pbrShader.use();
-	pbrShader.setMat4("projection", projection);
-	backgroundShader.use();
-	backgroundShader.setMat4("projection", projection);
+	for (Shader* shader : { &pbrShader, &pbrOrmShader, &pbrArrayShader, &pbrOrmArrayShader, &backgroundShader })
+	{
+		shader->bindUniformBlock("FrameUniforms", FRAME_UNIFORM_BINDING);
+		shader->bindUniformBlock("ObjectUniforms", OBJECT_UNIFORM_BINDING);
+	}
+	// 漫反射辐照度的球谐系数，只在切换环境时设置，不需要每帧设置
+	auto setIrradianceSH = [&](const IrradianceSH& sh) {
+		for (Shader* shader : { &pbrShader, &pbrOrmShader, &pbrArrayShader, &pbrOrmArrayShader })
+		{
+			shader->use();
+			shader->set(shader->uniform<glm::vec3>("irradianceSH"), &sh.coefficients[0][0], 9);
+		}
+	};
+	setIrradianceSH(irradianceSH);
+
+	// 每帧的uniform块数据（FrameUniforms和各物体的ObjectUniforms）写入环形缓冲，绘制前只需按偏移绑定
+	UniformRing uniformRing;
+	FrameUniformData frameUniforms = FrameUniformData();
+	frameUniforms.projection = projection;
+	const unsigned int lightCount = sizeof(lightPositions) / sizeof(lightPositions[0]);
+
+	// 运行时可切换的环境库：HDR目录下的所有环境贴图，启动时的环境作为当前环境。
+	// 选择新环境后在后台线程中加载缓存或在CPU上烘焙，每帧按时间预算上传，完成后在帧开始时替换
+	EnvironmentLibrary environments(iblParams, iblSwapBudgetMs, &meshPool);
+	environments.scan("resources/textures/hdr");
+	environments.adopt(hdrPath, iblTextures, irradianceSH);
 
 	// 在渲染前，将视口配置为原始framebuffer的屏幕尺寸
 	int scrWidth, scrHeight;
@@ -417,6 +654,15 @@ int main()
 		// 处理输入
 		processInput(window);
 
+		// 在每帧的上传预算内继续流式上传纹理
+		textureStreamer.update();
+		// 贴图全部加载完成后（同步加载时在第一帧）构建坦克的材质图集和合并网格
+		if (!tankBatched && textureStreamer.idle())
+			batchTankParts();
+		// 在预算内上传新环境的IBL纹理，全部完成后替换当前环境
+		if (environments.update())
+			setIrradianceSH(environments.currentIrradianceSH());
+
 		// 开始绘制ImGui界面
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
@@ -424,10 +670,16 @@ int main()
 
 		// 配置ImGui窗口位置和大小
 		ImGui::SetNextWindowPos(ImVec2(0, 0));
-		ImGui::SetNextWindowSize(ImVec2(460, 450));
+		ImGui::SetNextWindowSize(ImVec2(460, 600));
 		ImGui::Begin("Options");
 		// 显示FPS等信息
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)\n\n", deltaTime * 1000, 1.0f / deltaTime);
+		const GLStateStats& stateStats = GLStateCache::instance().lastFrameStats();
+		ImGui::Text("GL state changes: %u issued, %u filtered\n", stateStats.issued, stateStats.filtered);
+		const SceneDrawStats& sceneStats = scene.drawStats();
+		ImGui::Text("Render queue: %u draws, %u program / %u material changes\n\n", sceneStats.draws, sceneStats.programChanges, sceneStats.materialChanges);
+		if (!textureStreamer.idle())
+			ImGui::Text("Streaming textures: %d pending, %.1f MB uploaded\n\n", (int)textureStreamer.pendingCount(), textureStreamer.totalUploadedBytes() / (1024.0f * 1024.0f));
 		// 显示控制说明
 		ImGui::Text("Exit : Esc \n");
 		ImGui::Text("Camera Control : W A S D \n");
@@ -451,84 +703,92 @@ int main()
 		ImGui::Text("\nPokeBall Settings:\n");
 		ImGui::InputFloat3("PokeBall Translate", (float*)&pokeball_translate);
 		ImGui::SliderFloat("PokeBall Scale", (float*)&pokeball_scale, 0.1f, 20.0f);
+		PbrMaterialFactors& pokeballFactors = scene.materialFactors(pokeballMaterialHandle);
+		ImGui::ColorEdit3("PokeBall Albedo Tint", (float*)&pokeballFactors.albedoTint);
+		ImGui::SliderFloat("PokeBall Metallic Scale", &pokeballFactors.metallicScale, 0.0f, 2.0f);
+		ImGui::SliderFloat("PokeBall Roughness Scale", &pokeballFactors.roughnessScale, 0.0f, 2.0f);
+		ImGui::SliderFloat("PokeBall AO Strength", &pokeballFactors.aoStrength, 0.0f, 1.0f);
 		// tank 模型设置
 		ImGui::Text("\nTank Settings:\n");
 		ImGui::InputFloat3("Tank Translate", (float*)&tank_translate);
 		ImGui::SliderFloat("Tank Scale", (float*)&tank_scale, 0.1f, 20.0f);
+		// 环境贴图设置
+		ImGui::Text("\nEnvironment Settings:\n");
+		if (ImGui::BeginCombo("Environment", environments.path(environments.requested()).c_str()))
+		{
+			for (int i = 0; i < environments.size(); ++i)
+			{
+				if (ImGui::Selectable(environments.path(i).c_str(), i == environments.requested()))
+					environments.select(i);
+			}
+			ImGui::EndCombo();
+		}
+		if (environments.busy())
+			ImGui::Text("Loading environment...\n");
 		ImGui::End();
 
-		// 渲染
+		// 渲染。纹理的流式上传和环境切换已在上面完成，状态缓存从这里开始统计本帧的绑定
+		GLStateCache::instance().beginFrame();
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// 使用 pbrShader 进行场景渲染
-		pbrShader.use();
+		// 所有程序共用的每帧uniforms；光源位置在绘制模型前设置，使模型和光源球体使用同一帧的光照
 		glm::mat4 model = glm::mat4(1.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		pbrShader.setMat4("view", view);
-		pbrShader.setVec3("camPos", camera.Position);
+		// 按本帧要写入的块数预留环形缓冲：FrameUniforms一块，每个场景对象和光源球体各一块
+		uniformRing.reserve(uniformRing.blockSize<FrameUniformData>() + (scene.renderableCount() + lightCount) * uniformRing.blockSize<ObjectUniformData>());
+		uniformRing.beginFrame();
+		frameUniforms.view = camera.GetViewMatrix();
+		frameUniforms.camPos = camera.Position;
+		for (unsigned int i = 0; i < lightCount && i < MAX_LIGHTS; ++i)
+		{
+			frameUniforms.lightPositions[i] = glm::vec4(lightPositions[i], 1.0f);
+			frameUniforms.lightColors[i] = glm::vec4(lightColors[i], 1.0f);
+		}
+		uniformRing.push(FRAME_UNIFORM_BINDING, frameUniforms);
 
 		// 绑定预计算的 IBL 数据
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-
-		// 渲染 pokeball 模型
+		GLStateCache::instance().bindTexture(1, GL_TEXTURE_CUBE_MAP, environments.current().prefilter);
+		GLStateCache::instance().bindTexture(2, GL_TEXTURE_2D, brdfLUTTexture);
+
+		// pokeball 模型的变换
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, pokeball_translate);
 		model = glm::scale(model, glm::vec3(pokeball_scale, pokeball_scale, pokeball_scale));
-		renderPbrModel(modelAlbedoMap0, modelNormalMap0, modelMetallicMap0, modelRoughnessMap0, modelAoMapModel0, pbrShader, pokeball, model);
+		scene.setTransform(pokeballRenderable, model);
 
-		// 渲染 tank 模型
+		// tank 模型的变换
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, tank_translate);
 		model = glm::scale(model, glm::vec3(tank_scale, tank_scale, tank_scale));
-		renderPbrModel(modelAlbedoMap1, modelNormalMap1, modelMetallicMap1, modelRoughnessMap1, modelAoMapModel1, pbrShader, hull, model);
-		renderPbrModel(modelAlbedoMap2, modelNormalMap2, modelMetallicMap2, modelRoughnessMap2, modelAoMapModel2, pbrShader, track, model);
-		renderPbrModel(modelAlbedoMap3, modelNormalMap3, modelMetallicMap3, modelRoughnessMap3, modelAoMapModel3, pbrShader, turret, model);
-		renderPbrModel(modelAlbedoMap4, modelNormalMap4, modelMetallicMap4, modelRoughnessMap4, modelAoMapModel4, pbrShader, wheels, model);
-		renderPbrModel(modelAlbedoMap5, modelNormalMap5, modelMetallicMap5, modelRoughnessMap5, modelAoMapModel5, pbrShader, floor, model);
-
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, goldAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, goldNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, goldMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, goldRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, goldAOMap);
+		for (RenderableHandle tankRenderable : tankRenderables)
+			scene.setTransform(tankRenderable, model);
+
+		// 渲染 pokeball 和 tank 模型：按程序、材质、网格和深度排序后绘制
+		scene.draw(uniformRing, camera.Position);
+
 		// 渲染光源
-		for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+		goldMaterial.bind();
+		for (unsigned int i = 0; i < lightCount; ++i)
 		{
-			glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
-			newPos = lightPositions[i];
-			pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-			pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-
 			model = glm::mat4(1.0f);
-			model = glm::translate(model, newPos);
+			model = glm::translate(model, lightPositions[i]);
 			model = glm::scale(model, glm::vec3(0.5f));
-			pbrShader.setMat4("model", model);
-			pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
+			ObjectUniformData lightObject;
+			lightObject.setTransform(model);
 			// 渲染光源形状为球体
-			renderSphere();
+			if (uniformRing.push(OBJECT_UNIFORM_BINDING, lightObject))
+				renderSphere();
 		}
 
 		// 渲染天空盒，作为背景
 		backgroundShader.use();
-		backgroundShader.setMat4("view", view);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		GLStateCache::instance().bindTexture(0, GL_TEXTURE_CUBE_MAP, environments.current().environment);
 		renderCube();
 
 		// 渲染ImGui的绘制数据
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		uniformRing.endFrame();
 
 		// glfw: 交换缓冲并查询IO事件 (如键盘按下/释放，鼠标移动等)
 		glfwSwapBuffers(window);
@@ -604,25 +864,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-// 渲染（并在第一次调用时构建）一个已加载的PBR模型
-void renderPbrModel(unsigned int albedoMap, unsigned int normalMap, unsigned int metallicMap, unsigned int roughnessMap, unsigned int aoMap, Shader& pbrShader, Model inputModel, glm::mat4 model)
-{
-	// 设置PBR纹理
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, albedoMap);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, normalMap);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, metallicMap);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, roughnessMap);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D, aoMap);
-
-	pbrShader.setMat4("model", model);
-	inputModel.Draw(pbrShader);
-}
-
 // 首次调用时构建并渲染一个球体
 unsigned int sphereVAO = 0;
 GLsizei indexCount;
@@ -704,7 +945,7 @@ void renderSphere()
 			}
 		}
 		// 绑定和设置OpenGL缓冲区
-		glBindVertexArray(sphereVAO);
+		GLStateCache::instance().bindVertexArray(sphereVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -718,7 +959,7 @@ void renderSphere()
 		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
 	}
 	// 绘制球体
-	glBindVertexArray(sphereVAO);
+	GLStateCache::instance().bindVertexArray(sphereVAO);
 	glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
 }
 
@@ -780,7 +1021,7 @@ void renderCube()
 		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 		// 链接顶点属性
-		glBindVertexArray(cubeVAO);
+		GLStateCache::instance().bindVertexArray(cubeVAO);
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 		glEnableVertexAttribArray(1);
@@ -788,78 +1029,8 @@ void renderCube()
 		glEnableVertexAttribArray(2);
 		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
 	}
 	// 渲染立方体
-	glBindVertexArray(cubeVAO);
+	GLStateCache::instance().bindVertexArray(cubeVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
-
-// renderQuad() 函数用于渲染一个1x1的XY平面在NDC中
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-void renderQuad()
-{
-	if (quadVAO == 0)
-	{
-		float quadVertices[] = {
-			// 位置        // 纹理坐标
-			-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-			-1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-			 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-			 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-		};
-		// 设置平面的VAO
-		glGenVertexArrays(1, &quadVAO);
-		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	}
-	glBindVertexArray(quadVAO);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
-}
-
-// 用于从文件加载2D纹理的函数
-unsigned int loadTexture(char const* path)
-{
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
 }
@@ -4,30 +4,65 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// ʲ
-uniform sampler2D albedoMap;
-uniform sampler2D normalMap;
-uniform sampler2D metallicMap;
-uniform sampler2D roughnessMap;
-uniform sampler2D aoMap;
-
-// IBL
-uniform samplerCube irradianceMap;
+// ʲUSE_MATERIAL_ARRAYиͼΪͼ飬㴫ĲŲ
+#ifdef USE_MATERIAL_ARRAY
+flat in float MaterialLayer;
+#define MATERIAL_SAMPLER sampler2DArray
+#define SAMPLE_MATERIAL(map) texture(map, vec3(TexCoords, MaterialLayer))
+#else
+#define MATERIAL_SAMPLER sampler2D
+#define SAMPLE_MATERIAL(map) texture(map, TexCoords)
+#endif
+uniform MATERIAL_SAMPLER albedoMap;
+uniform MATERIAL_SAMPLER normalMap;
+#ifdef USE_ORM_MAP
+// ORMͼRΪaoGΪroughnessBΪmetallic
+uniform MATERIAL_SAMPLER ormMap;
+#else
+uniform MATERIAL_SAMPLER metallicMap;
+uniform MATERIAL_SAMPLER roughnessMap;
+uniform MATERIAL_SAMPLER aoMap;
+#endif
+// ʵımaterial.hеPbrMaterialFactorsӦֵıͼĽ
+uniform vec3 albedoTint = vec3(1.0);
+uniform float metallicScale = 1.0;
+uniform float roughnessScale = 1.0;
+uniform float aoStrength = 1.0;
+
+// IBLնΪL2гϵѺҾ1/PIspherical_harmonics.h
+uniform vec3 irradianceSH[9];
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
-// Դ
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
-
-uniform vec3 camPos;
+// ÿ֡͹Դݣuniform_buffer.hеFrameUniformDataӦ
+layout (std140) uniform FrameUniforms
+{
+    mat4 projection;
+    mat4 view;
+    vec3 camPos;
+    vec3 lightPositions[4];
+    vec3 lightColors[4];
+};
 
 const float PI = 3.14159265359;
 
+// ڷ߷nֵնгȡֵԭնͼͬ
+vec3 irradianceFromSH(vec3 n)
+{
+    vec3 irradiance = irradianceSH[0]
+                    + irradianceSH[1] * n.y + irradianceSH[2] * n.z + irradianceSH[3] * n.x
+                    + irradianceSH[4] * (n.x * n.y) + irradianceSH[5] * (n.y * n.z) + irradianceSH[6] * (3.0 * n.z * n.z - 1.0)
+                    + irradianceSH[7] * (n.x * n.z) + irradianceSH[8] * (n.x * n.x - n.y * n.y);
+    return max(irradiance, vec3(0.0));
+}
+
 // ӷͼлȡϢļ׷ڼPBR
 vec3 getNormalFromMap()
 {
-    vec3 tangentNormal = texture(normalMap, TexCoords).xyz * 2.0 - 1.0;
+    // ֻʹxyؽzBC5ѹķͼֻRGͨδѹķͼͬ
+    vec3 tangentNormal;
+    tangentNormal.xy = SAMPLE_MATERIAL(normalMap).xy * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
@@ -95,10 +130,21 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 void main()
 {		
     // 
-    vec3 albedo = pow(texture(albedoMap, TexCoords).rgb, vec3(2.2));
-    float metallic = texture(metallicMap, TexCoords).r;
-    float roughness = texture(roughnessMap, TexCoords).r;
-    float ao = texture(aoMap, TexCoords).r;
+    vec3 albedo = pow(SAMPLE_MATERIAL(albedoMap).rgb, vec3(2.2));
+#ifdef USE_ORM_MAP
+    vec3 orm = SAMPLE_MATERIAL(ormMap).rgb;
+    float ao = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
+#else
+    float metallic = SAMPLE_MATERIAL(metallicMap).r;
+    float roughness = SAMPLE_MATERIAL(roughnessMap).r;
+    float ao = SAMPLE_MATERIAL(aoMap).r;
+#endif
+    albedo *= albedoTint;
+    metallic = clamp(metallic * metallicScale, 0.0, 1.0);
+    roughness = clamp(roughness * roughnessScale, 0.0, 1.0);
+    ao = mix(1.0, ao, aoStrength);
        
     // 
     vec3 N = getNormalFromMap();
@@ -147,7 +193,7 @@ void main()
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
     
-    vec3 irradiance = texture(irradianceMap, N).rgb;
+    vec3 irradiance = irradianceFromSH(N);
     vec3 diffuse      = irradiance * albedo;
     
     // Ԥ˲ͼBRDFұвSplit-SumƽһԻIBL沿
@@ -2,19 +2,39 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef USE_MATERIAL_ARRAY
+// ϲÿĲͼеĲ㣬mesh_batch.h
+layout (location = 7) in float aMaterialLayer;
+flat out float MaterialLayer;
+#endif
 
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
-uniform mat3 normalMatrix;
+// ÿ֡͹Դݣuniform_buffer.hеFrameUniformDataӦ
+layout (std140) uniform FrameUniforms
+{
+    mat4 projection;
+    mat4 view;
+    vec3 camPos;
+    vec3 lightPositions[4];
+    vec3 lightColors[4];
+};
+
+// ÿı任ObjectUniformDataӦ
+layout (std140) uniform ObjectUniforms
+{
+    mat4 model;
+    mat3 normalMatrix;
+};
 
 void main()
 {
     TexCoords = aTexCoords;
+#ifdef USE_MATERIAL_ARRAY
+    MaterialLayer = aMaterialLayer;
+#endif
     WorldPos = vec3(model * vec4(aPos, 1.0));
     Normal = normalMatrix * aNormal;   
 
@@ -0,0 +1,446 @@
+﻿#include <bc_encoder.h>
+#include <cooked_texture.h>
+#include <file_system.h>
+#include <image.h>
+#include <thread_pool.h>
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 离线资源烘焙工具（无窗口、无GL上下文）：
+// 先把每个材质的ao/roughness/metallic打包为一张<前缀>orm.tga，
+// 再遍历资源目录下的所有图像，在线程池中解码并生成完整mip链，按贴图用途压缩为BC格式后写出到同目录下的<图像>.ctex，
+// 运行时映射该文件逐级上传，省去启动时的解码和glGenerateMipmap
+//
+// 用法：AssetCooker <资源目录> [--flip <子目录>]... [--force] [--uncompressed] [--bc1-albedo]
+//   --flip          该子目录（相对资源目录）下的图像烘焙时垂直翻转，需与运行时的加载方式一致
+//   --force         忽略修改时间，全部重新烘焙
+//   --uncompressed  不做块压缩
+//   --bc1-albedo    albedo贴图使用BC1（默认BC7，体积是BC1的两倍但质量更好）
+//
+//       AssetCooker --bench-bc <图像> [最大线程数]
+//   用1, 2, 4 ... 个线程分别以BC1/BC4/BC5/BC7编码该图像，输出吞吐量和PSNR
+
+struct CookOptions {
+    bool compress = true;
+    bool bc1Albedo = false;
+};
+
+struct CookResult {
+    bool cooked = false;
+    int width = 0;
+    int height = 0;
+    int levels = 0;
+    uint32_t format = COOKED_FORMAT_UNCOMPRESSED;
+    size_t bytes = 0;
+    double ms = 0.0;
+};
+
+static const char* formatName(uint32_t format)
+{
+    static const char* names[] = { "RGBA8", "BC1", "BC4", "BC5", "BC7" };
+    return format <= COOKED_FORMAT_BC7 ? names[format] : "?";
+}
+
+// 判断是否为可烘焙的8位图像（HDR环境贴图由IBL流程单独处理）
+static bool isCookableImage(const std::string& path)
+{
+    std::string extension = fileExtension(path);
+    return extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "tga" || extension == "bmp";
+}
+
+// 小写的文件名（不含目录和扩展名）
+static std::string lowerStem(const std::string& path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    name = name.substr(0, name.find_last_of('.'));
+    for (unsigned int i = 0; i < name.size(); i++)
+        name[i] = (char)tolower((unsigned char)name[i]);
+    return name;
+}
+
+static bool endsWith(const std::string& name, const std::string& suffix)
+{
+    return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// 按文件名判断贴图用途：albedo和打包的ORM贴图用BC7（或BC1），法线用BC5（着色器重建z），ao/roughness/metallic等标量贴图用BC4
+static uint32_t chooseFormat(const std::string& path, int nrComponents, const CookOptions& options)
+{
+    if (!options.compress)
+        return COOKED_FORMAT_UNCOMPRESSED;
+    std::string name = lowerStem(path);
+    if (endsWith(name, "albedo") || endsWith(name, "orm"))
+        return options.bc1Albedo ? COOKED_FORMAT_BC1 : COOKED_FORMAT_BC7;
+    if (endsWith(name, "normal") && nrComponents >= 2)
+        return COOKED_FORMAT_BC5;
+    if (endsWith(name, "ao") || endsWith(name, "roughness") || endsWith(name, "metallic"))
+        return COOKED_FORMAT_BC4;
+    return COOKED_FORMAT_UNCOMPRESSED;
+}
+
+// ORM打包：同一目录下同一前缀的ao/roughness/metallic贴图合并为一张<前缀>orm.tga（R: ao, G: roughness, B: metallic），
+// 之后和其他图像一样被烘焙。运行时找到ORM贴图时只采样这一张，不再加载三张单独的贴图
+struct OrmGroup {
+    std::string prefix;
+    std::string sources[3];     // ao, roughness, metallic，缺失时为空
+};
+
+static std::string ormPath(const OrmGroup& group)
+{
+    return group.prefix + "orm.tga";
+}
+
+// 找出至少有两张标量贴图的材质，只有一张时打包没有收益
+static std::vector<OrmGroup> findOrmGroups(const std::vector<std::string>& files)
+{
+    static const char* suffixes[3] = { "ao", "roughness", "metallic" };
+    std::vector<OrmGroup> groups;
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        const std::string& path = files[i];
+        if (!isCookableImage(path) || fileExtension(path) == "tga")
+            continue;
+        std::string name = lowerStem(path);
+        size_t nameStart = path.find_last_of('/') + 1;
+        for (int k = 0; k < 3; k++)
+        {
+            if (!endsWith(name, suffixes[k]))
+                continue;
+            std::string prefix = path.substr(0, nameStart + name.size() - strlen(suffixes[k]));
+            unsigned int g = 0;
+            while (g < groups.size() && groups[g].prefix != prefix)
+                g++;
+            if (g == groups.size())
+            {
+                groups.push_back(OrmGroup());
+                groups.back().prefix = prefix;
+            }
+            groups[g].sources[k] = path;
+            break;
+        }
+    }
+
+    std::vector<OrmGroup> packable;
+    for (unsigned int g = 0; g < groups.size(); g++)
+    {
+        int count = 0;
+        for (int k = 0; k < 3; k++)
+            count += groups[g].sources[k].empty() ? 0 : 1;
+        if (count >= 2)
+            packable.push_back(groups[g]);
+    }
+    return packable;
+}
+
+// 双线性采样第0个通道，u/v为[0, 1]的纹理坐标
+static float sampleChannel(const ImageData& image, float u, float v)
+{
+    float x = std::min(std::max(u * image.width - 0.5f, 0.0f), image.width - 1.0f);
+    float y = std::min(std::max(v * image.height - 0.5f, 0.0f), image.height - 1.0f);
+    int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    int x1 = std::min(x0 + 1, image.width - 1), y1 = std::min(y0 + 1, image.height - 1);
+    float fx = x - x0, fy = y - y0;
+    auto texel = [&image](int tx, int ty) { return static_cast<float>(image.data[((size_t)ty * image.width + tx) * image.nrComponents]); };
+    float top = texel(x0, y0) + (texel(x1, y0) - texel(x0, y0)) * fx;
+    float bottom = texel(x0, y1) + (texel(x1, y1) - texel(x0, y1)) * fx;
+    return top + (bottom - top) * fy;
+}
+
+// 生成一组材质的ORM贴图，尺寸取各来源中最大的，尺寸不同的来源双线性缩放。
+// 缺失的通道填0，与运行时单独加载时缺失贴图采样为0的效果一致
+static bool packOrm(const OrmGroup& group)
+{
+    ImageData sources[3];
+    int width = 0, height = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        if (group.sources[k].empty())
+            continue;
+        sources[k] = decodeImage(group.sources[k]);
+        width = std::max(width, sources[k].width);
+        height = std::max(height, sources[k].height);
+    }
+
+    bool packed = width > 0 && height > 0;
+    std::vector<unsigned char> pixels((size_t)width * height * 3, 0);
+    for (int k = 0; k < 3 && packed; k++)
+    {
+        const ImageData& source = sources[k];
+        if (!source.data)
+            continue;
+        bool sameSize = source.width == width && source.height == height;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                float value = sameSize ? source.data[((size_t)y * width + x) * source.nrComponents]
+                                       : sampleChannel(source, (x + 0.5f) / width, (y + 0.5f) / height);
+                pixels[((size_t)y * width + x) * 3 + k] = static_cast<unsigned char>(value + 0.5f);
+            }
+        }
+    }
+    if (packed)
+        packed = writeImageTGA(ormPath(group), pixels.data(), width, height, 3);
+    for (int k = 0; k < 3; k++)
+        freeImage(sources[k]);
+    return packed;
+}
+
+// 在线程池的工作线程中执行，因此BC编码在本线程串行进行，并行度来自同时烘焙多个文件
+static CookResult cookTexture(const std::string& path, bool flipVertically, const CookOptions& options)
+{
+    CookResult result;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    ImageData image = decodeImage(path, flipVertically);
+    if (!image.data)
+        return result;
+
+    std::vector<int> widths, heights;
+    std::vector<std::vector<unsigned char>> mips = generateMipChain(image.data, image.width, image.height, image.nrComponents, widths, heights);
+
+    std::vector<CookedLevelData> levels;
+    levels.push_back(CookedLevelData{ image.width, image.height, image.data, (size_t)image.width * image.height * image.nrComponents });
+    for (unsigned int i = 0; i < mips.size(); i++)
+        levels.push_back(CookedLevelData{ widths[i], heights[i], mips[i].data(), mips[i].size() });
+
+    uint32_t format = chooseFormat(path, image.nrComponents, options);
+    std::vector<std::vector<unsigned char>> blocks;
+    if (format != COOKED_FORMAT_UNCOMPRESSED)
+    {
+        blocks.resize(levels.size());
+        for (unsigned int i = 0; i < levels.size(); i++)
+        {
+            compressImage(levels[i].data, levels[i].width, levels[i].height, image.nrComponents, format, blocks[i]);
+            levels[i].data = blocks[i].data();
+            levels[i].size = blocks[i].size();
+        }
+    }
+
+    CookedTextureHeader header;
+    header.width = image.width;
+    header.height = image.height;
+    header.nrComponents = image.nrComponents;
+    header.format = format;
+    header.flags = flipVertically ? COOKED_FLAG_FLIPPED_VERTICALLY : 0;
+
+    result.cooked = writeCookedTexture(cookedTexturePath(path), header, levels);
+    result.width = image.width;
+    result.height = image.height;
+    result.levels = static_cast<int>(levels.size());
+    result.format = format;
+    for (unsigned int i = 0; i < levels.size(); i++)
+        result.bytes += levels[i].size;
+    freeImage(image);
+
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return result;
+}
+
+// 解码压缩结果并与原图比较，只统计该格式保存的通道
+static double measurePSNR(const ImageData& image, uint32_t format, const std::vector<unsigned char>& blocks)
+{
+    int channels = format == COOKED_FORMAT_BC4 ? 1 : (format == COOKED_FORMAT_BC5 ? 2 : (format == COOKED_FORMAT_BC1 ? 3 : 4));
+    int blocksX = (image.width + 3) / 4;
+    int blocksY = (image.height + 3) / 4;
+    size_t blockBytes = cookedBlockBytes(format);
+    double squaredError = 0.0;
+    size_t samples = 0;
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const unsigned char* block = blocks.data() + ((size_t)by * blocksX + bx) * blockBytes;
+            unsigned char decoded[16][4] = {};
+            if (format == COOKED_FORMAT_BC1)
+                decodeBC1Block(block, decoded);
+            else if (format == COOKED_FORMAT_BC7)
+                decodeBC7Block(block, decoded);
+            else
+            {
+                for (int c = 0; c < (format == COOKED_FORMAT_BC5 ? 2 : 1); c++)
+                {
+                    unsigned char values[16];
+                    decodeBC4Block(block + c * 8, values);
+                    for (int i = 0; i < 16; i++)
+                        decoded[i][c] = values[i];
+                }
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x >= image.width || y >= image.height)
+                    continue;
+                const unsigned char* source = image.data + ((size_t)y * image.width + x) * image.nrComponents;
+                for (int c = 0; c < channels; c++)
+                {
+                    int original = c < image.nrComponents ? source[c] : (c == 3 ? 255 : 0);
+                    double d = double(decoded[i][c]) - original;
+                    squaredError += d * d;
+                    samples++;
+                }
+            }
+        }
+    }
+    double mse = squaredError / std::max<size_t>(samples, 1);
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// 编码器的吞吐量和质量测试
+static int benchmarkBC(const std::string& path, unsigned int maxThreads)
+{
+    ImageData image = decodeImage(path);
+    if (!image.data)
+    {
+        std::cout << "Failed to load " << path << std::endl;
+        return 1;
+    }
+    if (maxThreads == 0)
+        maxThreads = ThreadPool::defaultThreadCount();
+
+    double megapixels = image.width * (double)image.height / 1e6;
+    std::cout << "BC encoder benchmark: " << path << " (" << image.width << "x" << image.height << ", " << image.nrComponents
+              << " channels)" << std::endl;
+    const uint32_t formats[] = { COOKED_FORMAT_BC1, COOKED_FORMAT_BC4, COOKED_FORMAT_BC5, COOKED_FORMAT_BC7 };
+    for (uint32_t format : formats)
+    {
+        std::vector<unsigned char> blocks;
+        double singleThreadMs = 0.0;
+        for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+        {
+            ThreadPool pool(threads);
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            compressImage(image.data, image.width, image.height, image.nrComponents, format, blocks, &pool);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (threads == 1)
+                singleThreadMs = ms;
+            std::cout << "  " << formatName(format) << " threads " << std::setw(3) << threads << " | " << std::fixed << std::setprecision(1)
+                      << std::setw(8) << ms << " ms | " << std::setw(7) << megapixels / (ms / 1000.0) << " MPix/s | speedup "
+                      << std::setprecision(2) << singleThreadMs / ms << "x" << std::defaultfloat << std::endl;
+            if (threads == maxThreads)
+                break;
+        }
+        std::cout << "  " << formatName(format) << " PSNR " << std::fixed << std::setprecision(2) << measurePSNR(image, format, blocks)
+                  << " dB | " << std::setprecision(1) << blocks.size() / 1024.0 << " KB (uncompressed "
+                  << (size_t)image.width * image.height * image.nrComponents / 1024.0 << " KB)" << std::defaultfloat << std::endl;
+    }
+    freeImage(image);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--bench-bc") == 0)
+        return benchmarkBC(argv[2], argc >= 4 ? static_cast<unsigned int>(atoi(argv[3])) : 0);
+    if (argc < 2)
+    {
+        std::cout << "Usage: AssetCooker <resourcesDir> [--flip <subdir>]... [--force] [--uncompressed] [--bc1-albedo]" << std::endl;
+        std::cout << "       AssetCooker --bench-bc <image> [maxThreads]" << std::endl;
+        return 1;
+    }
+
+    std::string resourcesDir = argv[1];
+    std::vector<std::string> flipDirs;
+    bool force = false;
+    CookOptions options;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--flip") == 0 && i + 1 < argc)
+            flipDirs.push_back(resourcesDir + '/' + argv[++i] + '/');
+        else if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (strcmp(argv[i], "--uncompressed") == 0)
+            options.compress = false;
+        else if (strcmp(argv[i], "--bc1-albedo") == 0)
+            options.bc1Albedo = true;
+        else
+        {
+            std::cout << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> files;
+    listFilesRecursive(resourcesDir, files);
+
+    ThreadPool pool;
+
+    // 先生成过期的ORM贴图，再重新列出文件，使它们和其他图像一起被烘焙
+    std::vector<OrmGroup> ormGroups = findOrmGroups(files);
+    std::vector<std::future<bool>> ormResults;
+    std::vector<std::string> ormOutputs;
+    for (unsigned int g = 0; g < ormGroups.size(); g++)
+    {
+        uint64_t newestSource = 0;
+        for (int k = 0; k < 3; k++)
+            newestSource = std::max(newestSource, fileModifiedTime(ormGroups[g].sources[k]));
+        if (!force && fileModifiedTime(ormPath(ormGroups[g])) >= newestSource)
+            continue;
+        OrmGroup group = ormGroups[g];
+        ormOutputs.push_back(ormPath(group));
+        ormResults.push_back(pool.enqueue([group] { return packOrm(group); }));
+    }
+    for (unsigned int i = 0; i < ormResults.size(); i++)
+        std::cout << (ormResults[i].get() ? "  packed  " : "  FAILED  ") << ormOutputs[i] << std::endl;
+    if (!ormResults.empty())
+    {
+        files.clear();
+        listFilesRecursive(resourcesDir, files);
+    }
+
+    std::vector<std::string> paths;
+    std::vector<std::future<CookResult>> results;
+    unsigned int upToDate = 0;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        const std::string& path = files[i];
+        if (!isCookableImage(path))
+            continue;
+        if (!force && fileModifiedTime(cookedTexturePath(path)) >= fileModifiedTime(path))
+        {
+            upToDate++;
+            continue;
+        }
+
+        bool flipVertically = false;
+        for (unsigned int j = 0; j < flipDirs.size(); j++)
+            flipVertically = flipVertically || path.compare(0, flipDirs[j].size(), flipDirs[j]) == 0;
+
+        paths.push_back(path);
+        results.push_back(pool.enqueue([path, flipVertically, options] { return cookTexture(path, flipVertically, options); }));
+    }
+
+    unsigned int failed = 0;
+    size_t totalBytes = 0;
+    for (unsigned int i = 0; i < results.size(); i++)
+    {
+        CookResult result = results[i].get();
+        if (!result.cooked)
+        {
+            std::cout << "  FAILED  " << paths[i] << std::endl;
+            failed++;
+            continue;
+        }
+        totalBytes += result.bytes;
+        std::cout << "  cooked  " << paths[i] << " (" << result.width << "x" << result.height << ", " << formatName(result.format) << ", " << result.levels
+                  << " levels, " << std::fixed << std::setprecision(1) << result.ms << " ms)" << std::defaultfloat << std::endl;
+    }
+
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "AssetCooker: " << results.size() - failed << " cooked, " << upToDate << " up to date, " << failed << " failed, "
+              << totalBytes / (1024 * 1024) << " MB written, " << pool.size() << " threads, " << std::fixed << std::setprecision(1)
+              << wallMs << " ms" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,346 @@
+﻿#include <ibl_baker.h>
+#include <ibl_cache.h>
+#include <thread_pool.h>
+#include <work_stealing_pool.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 离线IBL烘焙工具（无窗口、无GL上下文）：在CPU上复现运行时的IBL烘焙着色器和辐照度球谐投影，
+// 把结果写为HDR文件旁的.iblcache。缓存键与运行时相同（HDR内容哈希 + 默认烘焙参数 + 着色器源码哈希），
+// 因此在没有GPU的机器上烘焙的缓存可以直接被运行时使用
+//
+// 用法：IblBaker <HDR文件> [--shaders <目录>] [--threads <线程数>] [--scalar] [--force]
+//   --shaders   烘焙着色器所在目录（计算缓存键用），默认为当前目录，与运行时的工作目录一致
+//   --threads   参与计算的线程数，默认为硬件线程数
+//   --scalar    不使用SSE内核
+//   --force     缓存已是最新时也重新烘焙
+//
+//       IblBaker --bench <HDR文件> [最大线程数]
+//   用1, 2, 4 ... 个线程分别执行各阶段，输出每阶段的纹素吞吐量；单线程时另外测一次标量内核
+//
+//       IblBaker --brdf-lut <头文件> [--size <尺寸>] [--samples <采样数>] [--float] [--threads <线程数>]
+//   生成嵌入程序的BRDF积分查找表（PBR项目的预生成事件调用），默认512x512、1024个采样、半精度；
+//   --float以32位浮点保存。头文件中的参数与本次相同时不重新生成，避免每次构建都重新编译main.cpp
+
+// 各阶段耗时
+struct IblStageTimings {
+    double environmentMs = 0.0;
+    double shMs = 0.0;
+    double prefilterMs = 0.0;
+    double brdfMs = 0.0;
+};
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// brdfLut不为空时另外以默认参数生成BRDF LUT（只用于测试吞吐量，缓存中没有BRDF LUT）
+static void bakeIbl(const IblImage& source, const IblBakeParams& params, WorkStealingPool& pool, bool simd, IblBakeResult& result,
+                    IblStageTimings& timings, std::vector<float>* brdfLut = nullptr)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    bakeEnvironmentCube(source, static_cast<int>(params.environmentSize), pool, result.environment);
+    timings.environmentMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    result.irradianceSH = projectEnvironmentSH(result.environment, params, simd);
+    timings.shMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    bakePrefilter(result.environment, params, pool, simd, result.prefilter);
+    timings.prefilterMs = elapsedMs(start);
+
+    if (brdfLut)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        bakeBrdfLut(BrdfLutParams(), pool, simd, *brdfLut);
+        timings.brdfMs = elapsedMs(start);
+    }
+}
+
+// 各阶段输出的纹素数
+static void stageTexels(const IblBakeParams& params, double texels[4])
+{
+    texels[0] = 6.0 * params.environmentSize * params.environmentSize;
+    // 球谐投影读取的环境立方图纹素数，投影是单线程的线性遍历
+    texels[1] = 6.0 * params.shProjectionSize * params.shProjectionSize;
+    texels[2] = 0.0;
+    for (uint32_t level = 0; level < params.prefilterMipLevels; level++)
+    {
+        double size = std::max(1u, params.prefilterSize >> level);
+        texels[2] += 6.0 * size * size;
+    }
+    BrdfLutParams brdfParams;
+    texels[3] = (double)brdfParams.size * brdfParams.size;
+}
+
+static void printTimings(const char* label, unsigned int threads, const IblBakeParams& params, const IblStageTimings& timings,
+                         const IblStageTimings* baseline)
+{
+    static const char* names[4] = { "environment", "sh", "prefilter", "brdf" };
+    double texels[4];
+    stageTexels(params, texels);
+    double ms[4] = { timings.environmentMs, timings.shMs, timings.prefilterMs, timings.brdfMs };
+    double baseMs[4] = { 0.0, 0.0, 0.0, 0.0 };
+    if (baseline)
+    {
+        baseMs[0] = baseline->environmentMs;
+        baseMs[1] = baseline->shMs;
+        baseMs[2] = baseline->prefilterMs;
+        baseMs[3] = baseline->brdfMs;
+    }
+    int stageCount = timings.brdfMs > 0.0 ? 4 : 3;
+    for (int stage = 0; stage < stageCount; stage++)
+    {
+        std::cout << "  " << std::setw(6) << label << " threads " << std::setw(3) << threads << " | " << std::setw(11) << names[stage] << " | "
+                  << std::fixed << std::setprecision(1) << std::setw(9) << ms[stage] << " ms | " << std::setprecision(1) << std::setw(10)
+                  << texels[stage] / (ms[stage] / 1000.0) / 1e3 << " Ktexels/s";
+        if (baseline)
+            std::cout << " | speedup " << std::setprecision(2) << baseMs[stage] / ms[stage] << "x";
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+static int benchmarkIbl(const std::string& path, unsigned int maxThreads)
+{
+    if (maxThreads == 0)
+        maxThreads = ThreadPool::defaultThreadCount();
+    IblImage source;
+    {
+        ThreadPool decodePool(maxThreads);
+        if (!loadIblSource(path, source, &decodePool))
+        {
+            std::cout << "Failed to load " << path << std::endl;
+            return 1;
+        }
+    }
+    IblBakeParams params;
+    std::cout << "IBL bake benchmark: " << path << " (" << source.width << "x" << source.height << ")" << std::endl;
+
+    IblStageTimings singleThread;
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        WorkStealingPool pool(threads);
+        IblBakeResult result;
+        IblStageTimings timings;
+        std::vector<float> brdfLut;
+        bakeIbl(source, params, pool, true, result, timings, &brdfLut);
+        if (threads == 1)
+            singleThread = timings;
+        printTimings("simd", threads, params, timings, threads == 1 ? nullptr : &singleThread);
+        if (threads == 1)
+        {
+            // 同样单线程下的标量内核，speedup为SIMD相对标量的倍数
+            IblStageTimings scalar;
+            bakeIbl(source, params, pool, false, result, scalar, &brdfLut);
+            printTimings("scalar", threads, params, scalar, nullptr);
+            std::cout << "  simd vs scalar | sh " << std::fixed << std::setprecision(2) << scalar.shMs / timings.shMs
+                      << "x | prefilter " << scalar.prefilterMs / timings.prefilterMs << "x | brdf " << scalar.brdfMs / timings.brdfMs << "x"
+                      << std::defaultfloat << std::endl;
+
+            // 各级采样数相同（原着色器的做法）时的预过滤耗时，对比自适应采样数
+            IblBakeParams uniformParams = params;
+            uniformParams.prefilterMinSampleCount = params.prefilterSampleCount;
+            IblCubeMap uniformPrefilter;
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            bakePrefilter(result.environment, uniformParams, pool, true, uniformPrefilter);
+            double uniformMs = elapsedMs(start);
+            std::cout << "  prefilter samples per mip |";
+            for (uint32_t level = 0; level < params.prefilterMipLevels; level++)
+                std::cout << " " << prefilterSampleCount(params, level);
+            std::cout << " | " << std::fixed << std::setprecision(1) << timings.prefilterMs << " ms vs " << uniformMs << " ms with "
+                      << params.prefilterSampleCount << " each (" << std::setprecision(2) << uniformMs / timings.prefilterMs << "x)"
+                      << std::defaultfloat << std::endl;
+        }
+        if (threads == maxThreads)
+            break;
+    }
+    return 0;
+}
+
+// 生成的头文件第一行，记录生成参数。BRDF_LUT_GENERATOR_VERSION在积分的实现改变时增加
+const int BRDF_LUT_GENERATOR_VERSION = 1;
+
+static std::string brdfLutSignature(const BrdfLutParams& params)
+{
+    std::ostringstream signature;
+    signature << "// brdf-lut size=" << params.size << " samples=" << params.sampleCount << " format=" << (params.halfFloat ? "half" : "float")
+              << " generator=" << BRDF_LUT_GENERATOR_VERSION;
+    return signature.str();
+}
+
+static int writeBrdfLutHeader(int argc, char** argv)
+{
+    std::string path = argv[2];
+    BrdfLutParams params;
+    unsigned int threads = 0;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            params.size = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            params.sampleCount = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--float") == 0)
+            params.halfFloat = false;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = static_cast<unsigned int>(atoi(argv[++i]));
+        else
+        {
+            std::cout << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (params.size == 0 || params.sampleCount == 0)
+    {
+        std::cout << "Invalid BRDF LUT size or sample count" << std::endl;
+        return 1;
+    }
+
+    std::string signature = brdfLutSignature(params);
+    {
+        std::ifstream existing(path);
+        std::string firstLine;
+        if (existing && std::getline(existing, firstLine) && firstLine == signature)
+        {
+            std::cout << "  up to date  " << path << std::endl;
+            return 0;
+        }
+    }
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    WorkStealingPool pool(threads);
+    std::vector<float> lut;
+    bakeBrdfLut(params, pool, true, lut);
+
+    // 先写到临时文件再替换，构建中断时不会留下不完整的头文件
+    std::string temporaryPath = path + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "Failed to write " << temporaryPath << std::endl;
+        return 1;
+    }
+    fprintf(file, "%s\n", signature.c_str());
+    fprintf(file, "// Generated by IblBaker --brdf-lut at build time, do not edit. RG pairs, row-major, row y has roughness (y + 0.5) / size.\n");
+    fprintf(file, "#ifndef BRDF_LUT_DATA_H\n#define BRDF_LUT_DATA_H\n\n#include <cstdint>\n\n");
+    fprintf(file, "#define BRDF_LUT_SIZE %u\n#define BRDF_LUT_SAMPLE_COUNT %u\n#define BRDF_LUT_HALF_FLOAT %d\n\n", params.size, params.sampleCount,
+            params.halfFloat ? 1 : 0);
+    fprintf(file, "static const %s brdfLutData[BRDF_LUT_SIZE * BRDF_LUT_SIZE * 2] = {\n", params.halfFloat ? "uint16_t" : "float");
+    const size_t perLine = params.halfFloat ? 16 : 8;
+    for (size_t i = 0; i < lut.size(); i++)
+    {
+        if (i % perLine == 0)
+            fprintf(file, "    ");
+        if (params.halfFloat)
+            fprintf(file, "0x%04x,", floatToHalf(lut[i]));
+        else
+            fprintf(file, "%.9gf,", lut[i]);
+        fprintf(file, (i % perLine == perLine - 1 || i + 1 == lut.size()) ? "\n" : " ");
+    }
+    fprintf(file, "};\n#endif\n");
+    bool written = ferror(file) == 0;
+    written = fclose(file) == 0 && written;
+    if (written)
+    {
+        remove(path.c_str());
+        written = rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+    std::cout << (written ? "  generated  " : "  FAILED  ") << path << " | " << params.size << "x" << params.size << ", " << params.sampleCount
+              << " samples, " << (params.halfFloat ? "RG16F" : "RG32F") << ", " << std::fixed << std::setprecision(1) << elapsedMs(start) << " ms"
+              << std::defaultfloat << std::endl;
+    return written ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--bench") == 0)
+        return benchmarkIbl(argv[2], argc >= 4 ? static_cast<unsigned int>(atoi(argv[3])) : 0);
+    if (argc >= 3 && strcmp(argv[1], "--brdf-lut") == 0)
+        return writeBrdfLutHeader(argc, argv);
+    if (argc < 2)
+    {
+        std::cout << "Usage: IblBaker <hdr> [--shaders <dir>] [--threads <count>] [--scalar] [--force]" << std::endl;
+        std::cout << "       IblBaker --bench <hdr> [maxThreads]" << std::endl;
+        std::cout << "       IblBaker --brdf-lut <header> [--size <size>] [--samples <count>] [--float] [--threads <count>]" << std::endl;
+        return 1;
+    }
+
+    std::string hdrPath = argv[1];
+    std::string shaderDir;
+    unsigned int threads = 0;
+    bool simd = true;
+    bool force = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--shaders") == 0 && i + 1 < argc)
+            shaderDir = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = static_cast<unsigned int>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--scalar") == 0)
+            simd = false;
+        else if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else
+        {
+            std::cout << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    IblBakeParams params;
+    uint64_t bakeKey = iblBakeKey(params, iblBakeShaderPaths(shaderDir));
+    uint64_t sourceHash = 0, sourceSize = 0;
+    {
+        MappedFile cacheFile;
+        IblCacheView cache;
+        if (openIblCache(hdrPath, bakeKey, cacheFile, cache, sourceHash, sourceSize) && !force)
+        {
+            std::cout << "  up to date  " << iblCachePath(hdrPath) << std::endl;
+            return 0;
+        }
+    }
+    if (sourceSize == 0)
+    {
+        std::cout << "Failed to read " << hdrPath << std::endl;
+        return 1;
+    }
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    WorkStealingPool pool(threads);
+    IblImage source;
+    {
+        ThreadPool decodePool(pool.size());
+        if (!loadIblSource(hdrPath, source, &decodePool))
+        {
+            std::cout << "Failed to decode " << hdrPath << std::endl;
+            return 1;
+        }
+    }
+    double decodeMs = elapsedMs(start);
+
+    IblBakeResult result;
+    IblStageTimings timings;
+    bakeIbl(source, params, pool, simd, result, timings);
+
+    std::vector<std::vector<uint16_t>> storage;
+    std::vector<IblCacheImageData> images;
+    collectIblCacheImages(result, params, storage, images);
+    bool written = writeIblCache(hdrPath, sourceHash, sourceSize, bakeKey, result.irradianceSH, images);
+
+    std::cout << "  decode " << std::fixed << std::setprecision(1) << decodeMs << " ms (" << source.width << "x" << source.height << ")"
+              << std::defaultfloat << std::endl;
+    printTimings(simd ? "simd" : "scalar", pool.size(), params, timings, nullptr);
+    std::cout << (written ? "  baked  " : "  FAILED  ") << iblCachePath(hdrPath) << " | " << pool.size() << " threads, " << pool.stolenChunks()
+              << " chunks stolen, " << std::fixed << std::setprecision(1) << elapsedMs(start) << " ms" << std::defaultfloat << std::endl;
+    return written ? 0 : 1;
+}